@@ -0,0 +1,85 @@
+#include <assert.h>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <omp.h>
+#include "utils.h"
+#include "cpu/kernel.h"
+using namespace std;
+
+// Memory bandwidth of one group-kernel sweep over a 2^n state compared with a
+// STREAM-like copy / in-place scale over the same number of bytes. A group
+// with a single diagonal gate does almost no arithmetic, so its GB/s shows how
+// close fetch_data / save_data get to what the node can stream.
+// usage: bench-bandwidth [numQubits] [repeat]
+
+static cpx* alloc_state(int n) {
+    cpx* p;
+    if (posix_memalign((void**) &p, 64, sizeof(cpx) << n) != 0) {
+        UNREACHABLE();
+    }
+    #pragma omp parallel for
+    for (idx_t i = 0; i < (idx_t(1) << n); i++)
+        p[i] = cpx(1.0 / (i + 1), 0);
+    return p;
+}
+
+template<typename F>
+static double best_seconds(int repeat, F f) {
+    double best = 1e100;
+    for (int r = 0; r < repeat; r++) {
+        auto start = chrono::high_resolution_clock::now();
+        f();
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    MyMPI::init();
+    MyGlobalVars::init();
+    int n = argc > 1 ? atoi(argv[1]) : 28;
+    int repeat = argc > 2 ? atoi(argv[2]) : 5;
+    idx_t numElements = idx_t(1) << n;
+    double bytes = 2.0 * sizeof(cpx) * numElements; // one read and one write of the state
+    printf("n=%d state=%lld MB threads=%d llc=%lld KB streaming stores %s\n", n, (long long)(sizeof(cpx) << n) >> 20,
+        omp_get_max_threads(), (long long) CpuImpl::llcBytes >> 10, CpuImpl::use_stream_stores(sizeof(cpx) << n) ? "on" : "off");
+
+    cpx* a = alloc_state(n);
+    cpx* b = alloc_state(n);
+    double copy = best_seconds(repeat, [&]() {
+        #pragma omp parallel for
+        for (idx_t i = 0; i < numElements; i++)
+            b[i] = a[i];
+    });
+    printf("stream copy  %8.2f GB/s\n", bytes / copy / 1e9);
+    double scale = best_seconds(repeat, [&]() {
+        #pragma omp parallel for
+        for (idx_t i = 0; i < numElements; i++)
+            a[i] = a[i] * value_t(0.999);
+    });
+    printf("stream scale %8.2f GB/s\n", bytes / scale / 1e9);
+    free(b);
+
+    int blockQubits = MyGlobalVars::blockQubits;
+    cpx z[2][2] = {{cpx(1), cpx(0)}, {cpx(0), cpx(-1)}};
+    KernelGate gate = KernelGate::singleQubitGate(GateType::Z, 0, 0, z);
+    // related qubits: the low half of the block and the top qubits, like a typical group
+    int low = max(COALESCE_GLOBAL, blockQubits / 2);
+    idx_t related = ((idx_t(1) << low) - 1) | (((idx_t(1) << (blockQubits - low)) - 1) << (n - (blockQubits - low)));
+    double low_only = best_seconds(repeat, [&]() {
+        CpuImpl::kernels.svGroup(a, &gate, 1, (idx_t(1) << blockQubits) - 1, n, blockQubits);
+    });
+    printf("group (low)  %8.2f GB/s %5.1f%% of scale\n", bytes / low_only / 1e9, scale / low_only * 100);
+    double spread = best_seconds(repeat, [&]() {
+        CpuImpl::kernels.svGroup(a, &gate, 1, related, n, blockQubits);
+    });
+    printf("group (high) %8.2f GB/s %5.1f%% of scale\n", bytes / spread / 1e9, scale / spread * 100);
+    free(a);
+    #if USE_MPI
+        checkMPIErrors(MPI_Finalize());
+    #endif
+    return 0;
+}
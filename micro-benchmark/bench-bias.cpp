@@ -0,0 +1,70 @@
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <omp.h>
+#include "utils.h"
+#include "cpu/kernel.h"
+using namespace std;
+
+// Block biases of the group kernels computed per block (one PDEP) against read
+// from a per-group table (CPU_BIAS_TABLE), for every instantiated block size.
+// A group with a single diagonal gate is the case where the index work per
+// block weighs most against the arithmetic.
+// usage: bench-bias [numQubits] [repeat]
+
+template<typename F>
+static double best_seconds(int repeat, F f) {
+    double best = 1e100;
+    for (int r = 0; r < repeat; r++) {
+        auto start = chrono::high_resolution_clock::now();
+        f();
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    MyMPI::init();
+    MyGlobalVars::init();
+    int n = argc > 1 ? atoi(argv[1]) : 28;
+    int repeat = argc > 2 ? atoi(argv[2]) : 5;
+    printf("n=%d kernels=%s threads=%d\n", n, CpuImpl::kernels.name, omp_get_max_threads());
+
+    cpx* sv;
+    if (posix_memalign((void**) &sv, 64, sizeof(cpx) << n) != 0) {
+        UNREACHABLE();
+    }
+    #pragma omp parallel for
+    for (idx_t i = 0; i < (idx_t(1) << n); i++)
+        sv[i] = cpx(1.0 / (i + 1), 0);
+
+    cpx z[2][2] = {{cpx(1), cpx(0)}, {cpx(0), cpx(-1)}};
+    KernelGate gate = KernelGate::singleQubitGate(GateType::Z, 0, 0, z);
+    printf("block related   table(KB)   pdep(ms)  table(ms)  table/pdep\n");
+    for (int b = CpuImpl::MIN_BLOCK_QUBITS; b <= CpuImpl::MAX_BLOCK_QUBITS; b++) {
+        int low = max(COALESCE_GLOBAL, b / 2);
+        idx_t spread = ((idx_t(1) << low) - 1) | (((idx_t(1) << (b - low)) - 1) << (n - (b - low)));
+        idx_t relatedSets[2] = {(idx_t(1) << b) - 1, spread};
+        const char* names[2] = {"low", "high"};
+        for (int k = 0; k < 2; k++) {
+            idx_t related = relatedSets[k];
+            vector<unsigned int> table;
+            CpuImpl::block_bias_table(table, related, n, b);
+            double pdep = best_seconds(repeat, [&]() {
+                CpuImpl::kernels.svGroup(sv, &gate, 1, related, n, b);
+            });
+            double tab = best_seconds(repeat, [&]() {
+                CpuImpl::kernels.svGroupTable(sv, &gate, 1, related, table.data(), n, b);
+            });
+            printf("%5d %7s %11lld %10.2f %10.2f %11.3f\n", b, names[k], (long long) (table.size() * sizeof(unsigned int)) >> 10,
+                pdep * 1e3, tab * 1e3, tab / pdep);
+        }
+    }
+    free(sv);
+    #if USE_MPI
+        checkMPIErrors(MPI_Finalize());
+    #endif
+    return 0;
+}
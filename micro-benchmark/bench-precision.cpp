@@ -0,0 +1,35 @@
+#include <assert.h>
+#include <fstream>
+#include <cstring>
+#include <regex>
+#include <cmath>
+#include "circuit.h"
+#include "logger.h"
+using namespace std;
+
+// Throughput of the group kernels in the precision this binary is built with.
+// Build once with -DUSE_DOUBLE=on and once with -DUSE_DOUBLE=off and compare,
+// scripts/bench-precision-cpu.sh does both.
+int main(int argc, char* argv[]) {
+    MyMPI::init();
+    MyGlobalVars::init();
+    int n = argc > 1 ? atoi(argv[1]) : 28;
+    int num_gates = 512;
+    GateType types[] = {GateType::U3, GateType::H, GateType::RZ, GateType::CNOT, GateType::CU1};
+    printf("%s n=%d state=%lld MB\n", sizeof(value_t) == sizeof(double) ? "double" : "float", n, (long long)(sizeof(cpx) << n) >> 20);
+    for (int tt = 0; tt < 5; tt++) {
+        srand(tt);
+        Circuit c(n);
+        for (int k = 0; k < num_gates; k++) {
+            c.addGate(Gate::random(0, LOCAL_QUBIT_SIZE, types[k % 5]));
+        }
+        c.compile();
+        int time = c.run(false);
+        printf("%d us %.3f Gamp/s\n", time, double(num_gates) * (1ll << n) / time / 1e3);
+        fflush(stdout);
+    }
+    #if USE_MPI
+        checkMPIErrors(MPI_Finalize());
+    #endif
+    return 0;
+}
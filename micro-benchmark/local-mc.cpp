@@ -0,0 +1,45 @@
+#include <assert.h>
+#include <fstream>
+#include <cstring>
+#include <regex>
+#include <cmath>
+#include "circuit.h"
+#include "logger.h"
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    MyMPI::init();
+    MyGlobalVars::init();
+    int n = 28;
+    int num_gates = 512;
+    std::vector<std::pair<std::string, std::vector<cpx>>> mats = {
+        {"MCX", {cpx(0), cpx(1), cpx(1), cpx(0)}},
+        {"MCZ", {cpx(1), cpx(0), cpx(0), cpx(-1)}},
+    };
+    for (auto& mat: mats) {
+        printf("%s\n", mat.first.c_str());
+        // one row per number of controls, one column per target; the controls
+        // are the lowest qubits other than the target
+        for (int k = 2; k <= 4; k++) {
+            printf("%d: ", k);
+            for (int t = 0; t < LOCAL_QUBIT_SIZE; t++) {
+                std::vector<int> controls;
+                for (int q = 0; (int) controls.size() < k; q++)
+                    if (q != t) controls.push_back(q);
+                Circuit c(n);
+                for (int i = 0; i < num_gates; i++) {
+                    c.addGate(Gate::MCU(controls, t, mat.second));
+                }
+                c.compile();
+                int time = c.run(false);
+                printf("%d ", time);
+                fflush(stdout);
+            }
+            printf("\n");
+        }
+    }
+#if USE_MPI
+    checkMPIErrors(MPI_Finalize());
+#endif
+    return 0;
+}
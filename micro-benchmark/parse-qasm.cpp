@@ -0,0 +1,37 @@
+#include <assert.h>
+#include <chrono>
+#include <cstring>
+#include <sys/stat.h>
+#include "circuit.h"
+#include "parser.h"
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("./parse-qasm qasmfile|uqcfile ...\n");
+        exit(1);
+    }
+    int repeat = 5;
+    for (int i = 1; i < argc; i++) {
+        struct stat st;
+        if (stat(argv[i], &st) != 0) {
+            printf("fail to open %s\n", argv[i]);
+            exit(1);
+        }
+        int numGates = 0;
+        long long best = -1;
+        for (int r = 0; r < repeat; r++) {
+            auto start = chrono::system_clock::now();
+            auto c = load_circuit(std::string(argv[i]));
+            auto end = chrono::system_clock::now();
+            long long t = chrono::duration_cast<chrono::microseconds>(end - start).count();
+            numGates = c->gateCount();
+            if (best < 0 || t < best) best = t;
+        }
+        double sec = max(best, 1ll) / 1e6;
+        printf("%s: %d gates %.2f MB %lld us %.2f Mgates/s %.2f MB/s\n",
+            argv[i], numGates, st.st_size / 1e6, best, numGates / sec / 1e6, st.st_size / sec / 1e6);
+        fflush(stdout);
+    }
+    return 0;
+}
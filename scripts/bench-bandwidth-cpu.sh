@@ -0,0 +1,19 @@
+#!/bin/bash
+# GB/s of the CPU group kernels against a STREAM-like copy / scale, run from scripts/
+# usage: ./bench-bandwidth-cpu.sh [numQubits]
+set -u
+set -e
+
+name=../build/logs/bandwidth-`date +%Y%m%d-%H%M%S`
+mkdir -p $name
+n=${1:-28}
+
+for nt in off on; do
+    cd ../build
+    rm CMakeCache.txt || true
+    CC=`which mpicc` CXX=`which mpiicpc` cmake -DHARDWARE=cpu -DGPU_BACKEND=group -DSHOW_SUMMARY=on -DSHOW_SCHEDULE=off -DMICRO_BENCH=on -DUSE_DOUBLE=on -DCPU_STREAM_STORES=$nt -DDISABLE_ASSERT=on -DENABLE_OVERLAP=off -DMEASURE_STAGE=off -DEVALUATOR_PREPROCESS=off -DUSE_MPI=on ..
+    make clean
+    make -j bench-bandwidth
+    cd ../scripts
+    mpirun -n 1 ../build/bench-bandwidth $n 2>&1 | tee $name/stream-stores-$nt.out
+done
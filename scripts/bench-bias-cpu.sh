@@ -0,0 +1,17 @@
+#!/bin/bash
+# block biases from PDEP against per-group tables in the CPU group kernels, run from scripts/
+# usage: ./bench-bias-cpu.sh [numQubits]
+set -u
+set -e
+
+name=../build/logs/bias-`date +%Y%m%d-%H%M%S`
+mkdir -p $name
+n=${1:-28}
+
+cd ../build
+rm CMakeCache.txt || true
+CC=`which mpicc` CXX=`which mpiicpc` cmake -DHARDWARE=cpu -DGPU_BACKEND=group -DSHOW_SUMMARY=on -DSHOW_SCHEDULE=off -DMICRO_BENCH=on -DUSE_DOUBLE=on -DCPU_BIAS_TABLE=on -DDISABLE_ASSERT=on -DENABLE_OVERLAP=off -DMEASURE_STAGE=off -DEVALUATOR_PREPROCESS=off -DUSE_MPI=on ..
+make clean
+make -j bench-bias
+cd ../scripts
+mpirun -n 1 ../build/bench-bias $n 2>&1 | tee $name/bias.out
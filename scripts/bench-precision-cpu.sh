@@ -0,0 +1,19 @@
+#!/bin/bash
+# double vs float throughput of the CPU group kernels, run from scripts/
+# usage: ./bench-precision-cpu.sh [numQubits]
+set -u
+set -e
+
+name=../build/logs/precision-`date +%Y%m%d-%H%M%S`
+mkdir -p $name
+n=${1:-28}
+
+for prec in on off; do
+    cd ../build
+    rm CMakeCache.txt || true
+    CC=`which mpicc` CXX=`which mpiicpc` cmake -DHARDWARE=cpu -DGPU_BACKEND=group -DSHOW_SUMMARY=on -DSHOW_SCHEDULE=off -DMICRO_BENCH=on -DUSE_DOUBLE=$prec -DDISABLE_ASSERT=on -DENABLE_OVERLAP=off -DMEASURE_STAGE=off -DEVALUATOR_PREPROCESS=off -DUSE_MPI=on ..
+    make clean
+    make -j bench-precision
+    cd ../scripts
+    mpirun -n 1 ../build/bench-precision $n 2>&1 | tee $name/double-$prec.out
+done
@@ -0,0 +1,21 @@
+#!/bin/bash
+# blas backend on 2 ranks against tests/output, so that multi-controlled gates
+# see global controls, run from scripts/
+name=../build/logs/blas-`date +%Y%m%d-%H%M%S`
+mkdir -p $name
+export tests="ccx_20 permute_20 swap_20"
+MPIRUN_CONFIG="`which mpirun` -n 2 -genv OMP_NUM_THREADS=32 ../scripts/cpu-bind.sh"
+input_dir=../tests/input
+std_dir=../tests/output
+
+CC=`which mpicc` CXX=`which mpiicpc` source ../scripts/init.sh -DHARDWARE=cpu -DGPU_BACKEND=blas -DSHOW_SUMMARY=on -DSHOW_SCHEDULE=off -DMICRO_BENCH=off -DUSE_DOUBLE=on -DDISABLE_ASSERT=off -DENABLE_OVERLAP=off -DMEASURE_STAGE=off -DEVALUATOR_PREPROCESS=off -DUSE_MPI=on
+for test in $tests; do
+    $MPIRUN_CONFIG ./main $input_dir/$test.qasm > $name/$test.log
+done
+
+set +e
+for test in $tests; do
+    echo $test
+    grep -Ev "Logger|CLUSTER" $name/$test.log > tmp.log
+    diff -q -B $std_dir/$test.log tmp.log || true
+done
@@ -0,0 +1,25 @@
+#!/bin/bash
+# norm drift of the double, float and mixed precision CPU builds on tests/input,
+# run from scripts/
+name=../build/logs/precision-`date +%Y%m%d-%H%M%S`
+mkdir -p $name
+export tests="basis_change_25 bv_28 hidden_shift_28 qaoa_28 qft_28 quantum_volume_28 supremacy_28"
+MPIRUN_CONFIG="`which mpirun` -n 1 -genv OMP_NUM_THREADS=64 ../scripts/cpu-bind.sh"
+input_dir=../tests/input
+
+for prec in "double -DUSE_DOUBLE=on -DREPORT_NORM=on" "float -DUSE_DOUBLE=off" "mixed -DUSE_DOUBLE=off -DMIXED_PRECISION=on"; do
+    set -- $prec
+    mkdir -p $name/$1
+    CC=`which mpicc` CXX=`which mpiicpc` source ../scripts/init.sh -DHARDWARE=cpu -DGPU_BACKEND=group -DSHOW_SUMMARY=on -DSHOW_SCHEDULE=off -DMICRO_BENCH=off -DDISABLE_ASSERT=on -DENABLE_OVERLAP=off -DMEASURE_STAGE=off -DEVALUATOR_PREPROCESS=off -DUSE_MPI=on ${@: 2}
+    for test in $tests; do
+        $MPIRUN_CONFIG ./main $input_dir/$test.qasm > $name/$1/$test.log
+    done
+    cd ../scripts
+done
+
+for test in $tests; do
+    echo $test
+    for prec in double float mixed; do
+        echo "  $prec: `grep -h "Norm drift" $name/$prec/$test.log`"
+    done
+done
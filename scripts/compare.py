@@ -1,7 +1,7 @@
 import sys
 import os
 import numpy as np
-cases = ['adder_26', 'basis_change_28', 'bv_28', 'hidden_shift_28', 'ising_25', 'qaoa_28', 'qft_28', 'quantum_volume_28', 'supremacy_28']
+cases = ['adder_26', 'basis_change_28', 'bv_28', 'ccx_20', 'hidden_shift_28', 'ising_25', 'permute_20', 'qaoa_28', 'qft_28', 'quantum_volume_28', 'supremacy_28', 'swap_20']
 std_dir = sys.argv[1]
 my_dir = sys.argv[2]
 
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include "utils.h"
 #include "compiler.h"
+#include "schedule_cache.h"
 #include "logger.h"
 #ifdef USE_GPU
 #include "cuda/cuda_executor.h"
@@ -23,11 +24,13 @@ using namespace std;
 
 #if USE_GPU
 typedef CudaImpl::CudaExecutor DevExecutor;
+typedef Lowering DevLowering;
 #if MODE == 2
 typedef CudaImpl::CudaDMExecutor DevDMExecutor;
 #endif
 #elif USE_CPU
 typedef CpuImpl::CpuExecutor DevExecutor;
+typedef CpuImpl::CpuLowering DevLowering;
 #if MODE == 2
 typedef CpuImpl::CpuDMExecutor DevDMExecutor;
 #endif
@@ -454,6 +457,7 @@ idx_t Circuit::toPhysicalID(idx_t idx) {
     idx_t id = 0;
     auto& pos = schedule.finalState.pos;
 #if MODE != 2
+    idx ^= schedule.pauliFrame;
     for (int i = 0; i < numQubits; i++) {
         if (idx >> i & 1)
             id |= idx_t(1) << pos[i];
@@ -475,6 +479,7 @@ idx_t Circuit::toLogicID(idx_t idx) {
         if (idx >> pos[i] & 1)
             id |= idx_t(1) << i;
     }
+    id ^= schedule.pauliFrame;
 #else
     for (int i = 0; i < numQubits / 2; i++) {
         idx_t msk = (idx >> (pos[i] * 2) & 3);
@@ -506,6 +511,8 @@ cpx Circuit::ampAtGPU(idx_t idx) {
         idx_t localIdx = localID % localGPUAmp;
 #ifdef USE_GPU
         ret = CudaImpl::getAmp(deviceStateVec, gpuID, localIdx);
+#elif USE_CPU
+        ret = CpuImpl::getAmp(deviceStateVec, gpuID, localIdx);
 #else
         UNIMPLEMENTED(); // not implemented
 #endif
@@ -560,16 +567,27 @@ void Circuit::duplicate_conj() {
 
 void Circuit::masterCompile() {
     Logger::add("Total Gates %d", int(gates.size()));
+#if GPU_BACKEND == 1 || GPU_BACKEND == 2 || GPU_BACKEND == 3 || GPU_BACKEND == 4 || GPU_BACKEND == 5
+    uint64_t cacheKey = ScheduleCache::hash(numQubits, gates);
+    if (!ScheduleCache::load(cacheKey, schedule)) {
+#if MODE == 2
+        State qubitMap = Compiler::absorbSwaps(gates, numQubits / 2);
+#else
+        State qubitMap = Compiler::absorbSwaps(gates, numQubits);
+#endif
 #if GPU_BACKEND != 2 || ENABLE_TRANSFORM
-    this->transform();
+        this->transform();
 #endif
-#if GPU_BACKEND == 1 || GPU_BACKEND == 2 || GPU_BACKEND == 3 || GPU_BACKEND == 4 || GPU_BACKEND == 5
 #if MODE == 2
-    Compiler compiler(numQubits / 2, gates, MyGlobalVars::bit / 2);
+        Compiler compiler(numQubits / 2, gates, MyGlobalVars::bit / 2);
 #else
-    Compiler compiler(numQubits, gates, MyGlobalVars::bit);
+        Compiler compiler(numQubits, gates, MyGlobalVars::bit);
 #endif
-    schedule = compiler.run();
+        schedule = compiler.run();
+        schedule.qubitMap = qubitMap;
+        schedule.finalState = schedule.circuitState(schedule.finalState);
+        ScheduleCache::store(cacheKey, schedule);
+    }
     int totalGroups = 0;
     for (auto& lg: schedule.localGroups) totalGroups += lg.fullGroups.size();
     int fullGates = 0, overlapGates = 0;
@@ -586,29 +604,43 @@ void Circuit::masterCompile() {
 #endif
 #endif
 #else
-    schedule.finalState = State(numQubits);
+    schedule.qubitMap = Compiler::absorbSwaps(gates, numQubits);
+#if GPU_BACKEND != 2 || ENABLE_TRANSFORM
+    this->transform();
 #endif
+    schedule.finalState = schedule.circuitState(State(numQubits));
+#endif
+}
+
+#if USE_MPI
+// the count of MPI_Bcast is an int, so large schedules are sent in pieces
+static void bcast_bytes(unsigned char* buffer, idx_t size) {
+    const idx_t MAX_CHUNK = idx_t(1) << 30;
+    for (idx_t offset = 0; offset < size; offset += MAX_CHUNK) {
+        int count = (int) std::min(MAX_CHUNK, size - offset);
+        checkMPIErrors(MPI_Bcast(buffer + offset, count, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD));
+    }
 }
+#endif
 
 void Circuit::compile() {
+#if USE_CPU && defined(CPU_AUTOTUNE)
+    MyGlobalVars::blockQubits = CpuImpl::autotuneBlockQubits(numQubits - MyGlobalVars::bit);
+#endif
     auto start = chrono::system_clock::now();
 #if USE_MPI
     if (MyMPI::rank == 0) {
         masterCompile();
-        auto s = schedule.serialize();
-        int bufferSize = (int) s.size();
-        checkMPIErrors(MPI_Bcast(&bufferSize, 1, MPI_INT, 0, MPI_COMM_WORLD));
-        checkMPIErrors(MPI_Bcast(s.data(), bufferSize, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD));
-        // int cur = 0;
-        // schedule = Schedule::deserialize(s.data(), cur);
+        auto s = schedule.encode();
+        unsigned long long bufferSize = s.size();
+        checkMPIErrors(MPI_Bcast(&bufferSize, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD));
+        bcast_bytes(s.data(), bufferSize);
     } else {
-        int bufferSize;
-        checkMPIErrors(MPI_Bcast(&bufferSize, 1, MPI_INT, 0, MPI_COMM_WORLD));
-        unsigned char* buffer = new unsigned char [bufferSize];
-        checkMPIErrors(MPI_Bcast(buffer, bufferSize, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD));
-        int cur = 0;
-        schedule = Schedule::deserialize(buffer, cur);
-        delete[] buffer;
+        unsigned long long bufferSize;
+        checkMPIErrors(MPI_Bcast(&bufferSize, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD));
+        std::unique_ptr<unsigned char[]> buffer(new unsigned char[bufferSize]);
+        bcast_bytes(buffer.get(), bufferSize);
+        schedule = Schedule::decode(buffer.get(), bufferSize);
         fflush(stdout);
     }
 #else
@@ -618,6 +650,11 @@ void Circuit::compile() {
     schedule.initCuttPlans(numQubits - MyGlobalVars::bit);
 #ifndef OVERLAP_MAT
     schedule.initMatrix(numQubits);
+#endif
+#if MODE == 0 || MODE == 1
+    DevLowering(numQubits, schedule).lower();
+#elif MODE == 2
+    DMLowering(numQubits / 2, schedule).lower();
 #endif
     auto end = chrono::system_clock::now();
     auto duration1 = chrono::duration_cast<chrono::microseconds>(mid - start);
@@ -662,8 +699,27 @@ void Circuit::gatherAndPrint(const std::vector<ResultItem>& results) {
 }
 #endif
 
+// log how far the squared norm of the final state is from 1, accumulated in
+// double so that the float / mixed precision builds can be compared with the
+// double build
+#ifdef REPORT_NORM
+void Circuit::reportNorm() {
+    double norm = 0;
+    idx_t n = result.size();
+    #pragma omp parallel for reduction(+: norm)
+    for (idx_t i = 0; i < n; i++)
+        norm += double(result[i].real()) * result[i].real() + double(result[i].imag()) * result[i].imag();
+#if USE_MPI
+    checkMPIErrors(MPI_Allreduce(MPI_IN_PLACE, &norm, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD));
+#endif
+    Logger::add("Norm drift: %.3e", norm - 1);
+}
+#endif
 
 void Circuit::printState() {
+#if MODE == 0 && defined(REPORT_NORM)
+    reportNorm();
+#endif
 #if USE_MPI
     std::vector<ResultItem> results;
     ResultItem item;
@@ -756,40 +812,40 @@ void hczh2cx(std::vector<Gate> &gates, int numQubits, bool erased[]) {
         if (gate.type == GateType::CZ) {
             int h_low_ctr = -1, h_low_tar = -1, h_high_ctr = -1, h_high_tar = -1;
             for (int j = i - 1; j >= 0; j--) {
-                if (gates[j].targetQubit == gate.targetQubit) {
+                if (gates[j].hasTarget(gate.targetQubit)) {
                     if (gates[j].type == GateType::H && !erased[j]) {
                         h_low_tar = j;
                     }
                     break;
                 }
-                if (gates[j].controlQubit == gate.targetQubit) break;
+                if (gates[j].hasControl(gate.targetQubit)) break;
             }
             for (int j = i - 1; j >= 0; j--) {
-                if (gates[j].targetQubit == gate.controlQubit) {
+                if (gates[j].hasTarget(gate.controlQubit)) {
                     if (gates[j].type == GateType::H && !erased[j]) {
                         h_low_ctr = j;
                     }
                     break;
                 }
-                if (gates[j].controlQubit == gate.controlQubit) break;
+                if (gates[j].hasControl(gate.controlQubit)) break;
             }
             for (int j = i + 1; j < (int) gates.size(); j++) {
-                if (gates[j].targetQubit == gate.targetQubit) {
+                if (gates[j].hasTarget(gate.targetQubit)) {
                     if (gates[j].type == GateType::H && !erased[j]) {
                         h_high_tar = j;
                     }
                     break;
                 }
-                if (gates[j].controlQubit == gate.targetQubit) break;
+                if (gates[j].hasControl(gate.targetQubit)) break;
             }
             for (int j = i + 1; j < (int) gates.size(); j++) {
-                if (gates[j].targetQubit == gate.controlQubit) {
+                if (gates[j].hasTarget(gate.controlQubit)) {
                     if (gates[j].type == GateType::H && !erased[j]) {
                         h_high_ctr = j;
                     }
                     break;
                 }
-                if (gates[j].controlQubit == gate.controlQubit) break;
+                if (gates[j].hasControl(gate.controlQubit)) break;
             }
             if (h_low_tar != -1 && h_high_tar != -1) {
 #ifdef SHOW_SCHEDULE
@@ -812,6 +868,13 @@ void hczh2cx(std::vector<Gate> &gates, int numQubits, bool erased[]) {
     }
 }
 
+// a Pauli frame gate and a gate that is diagonal or Pauli too can both run on
+// a global qubit, their product (a general U) could not
+static bool keepForFrame(const Gate& a, const Gate& b) {
+    auto global = [](const Gate& g) { return g.isDiagonal() || g.isFramePauli(); };
+    return (a.isFramePauli() || b.isFramePauli()) && global(a) && global(b);
+}
+
 void single_qubit_fusion(std::vector<Gate> &gates, int numQubits, bool erased[]) {
     int lastGate[numQubits];
     memset(lastGate, -1, sizeof(int) * numQubits);
@@ -821,7 +884,7 @@ void single_qubit_fusion(std::vector<Gate> &gates, int numQubits, bool erased[])
         int old_id = lastGate[gate.targetQubit];
         if (gate.isSingleGate() && old_id != -1 && !erased[old_id]) {
             Gate& old = gates[old_id];
-            if (old.isSingleGate()) {
+            if (old.isSingleGate() && !keepForFrame(old, gate)) {
 #ifdef SHOW_SCHEDULE
                 printf("[single qubit fusion] %d %d\n", old_id, i);
 #endif
@@ -31,6 +31,15 @@ public:
     void addGate(const Gate& gate) {
         gates.push_back(gate);
     }
+    void addGates(std::vector<Gate>&& newGates) {
+        if (gates.empty()) {
+            gates = std::move(newGates);
+        } else {
+            gates.insert(gates.end(), std::make_move_iterator(newGates.begin()), std::make_move_iterator(newGates.end()));
+        }
+    }
+    int gateCount() const { return gates.size(); }
+    const std::vector<Gate>& getGates() const { return gates; }
     void dumpGates();
     void printState();
     ResultItem ampAt(idx_t idx);
@@ -48,6 +57,9 @@ private:
     void transform();
 #if USE_MPI
     void gatherAndPrint(const std::vector<ResultItem>& results);
+#endif
+#ifdef REPORT_NORM
+    void reportNorm();
 #endif
     std::vector<Gate> gates;
     std::vector<cpx*> deviceStateVec;
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <assert.h>
 #include <set>
+#include <queue>
 #include "dbg.h"
 #include "logger.h"
 #include "evaluator.h"
@@ -67,20 +68,144 @@ std::vector<std::pair<std::vector<Gate>, idx_t>> Compiler::moveToNext(LocalGroup
     return result;
 }
 
+State Compiler::absorbSwaps(std::vector<Gate>& gates, int numQubits) {
+    State qubitMap(numQubits);
+    auto& to = qubitMap.pos;
+    // gates before the first SWAP keep their qubits
+    size_t numKept = std::find_if(gates.begin(), gates.end(), [](const Gate& g) { return g.type == GateType::SWAP; }) - gates.begin();
+    for (size_t i = numKept; i < gates.size(); i++) {
+        Gate& g = gates[i];
+        if (g.type == GateType::SWAP) {
+            std::swap(to[g.encodeQubit], to[g.targetQubit]);
+            continue;
+        }
+        g.targetQubit = to[g.targetQubit];
+        if (g.isControlGate()) {
+            g.controlQubit = to[g.controlQubit];
+        } else if (g.isTwoQubitGate()) {
+            g.encodeQubit = to[g.encodeQubit];
+        } else if (g.isMCGate()) {
+            g.encodeQubit = 0;
+            for (auto& q: g.controlQubits) {
+                q = to[q];
+                g.encodeQubit |= idx_t(1) << q;
+            }
+        }
+        gates[numKept++] = g;
+    }
+    if (numKept < gates.size())
+        Logger::add("Absorbed %d swaps", int(gates.size() - numKept));
+    gates.resize(numKept);
+    for (int i = 0; i < numQubits; i++)
+        qubitMap.layout[to[i]] = i;
+    return qubitMap;
+}
+
+#ifdef LAZY_ACTIVATION
+static idx_t qubitSet(const Gate& g) {
+    idx_t ret = idx_t(1) << g.targetQubit;
+    if (g.isControlGate())
+        ret |= idx_t(1) << g.controlQubit;
+    if (g.isMCGate())
+        ret |= g.encodeQubit;
+    if (g.isTwoQubitGate())
+        ret |= idx_t(1) << g.encodeQubit;
+    return ret;
+}
+
+// qubits that may leave |0> at this gate: the targets of a non-diagonal gate
+static idx_t activatedBy(const Gate& g) {
+    return GateGroup::newRelated(0, g, (idx_t) -1, true);
+}
+
+// List scheduling over the per-qubit order of the gates: the first ready gate
+// that keeps every qubit it touches in its current state runs first, a gate
+// activating a new qubit only when no such gate is left. Once all qubits are
+// active, this is the input order.
+void Compiler::delayActivation() {
+    int numGates = gates.size();
+    std::vector<std::vector<int>> onQubit(numQubits);
+    std::vector<int> waiting(numGates);
+    for (int i = 0; i < numGates; i++) {
+        idx_t qubits = qubitSet(gates[i]);
+        waiting[i] = bitCount(qubits);
+        for (int q = 0; q < numQubits; q++)
+            if (qubits >> q & 1)
+                onQubit[q].push_back(i);
+    }
+    std::priority_queue<int, std::vector<int>, std::greater<int>> calm, waking;
+    idx_t active = 0;
+    auto arrive = [&](int i) {
+        if (--waiting[i] == 0)
+            ((activatedBy(gates[i]) & ~active) ? waking : calm).push(i);
+    };
+    std::vector<size_t> head(numQubits, 0);
+    for (int q = 0; q < numQubits; q++)
+        if (!onQubit[q].empty())
+            arrive(onQubit[q][0]);
+    std::vector<Gate> order;
+    order.reserve(numGates);
+    int moved = 0;
+    while ((int) order.size() < numGates) {
+        if (!calm.empty() && !waking.empty() && waking.top() < calm.top())
+            moved++;
+        auto& ready = calm.empty() ? waking : calm;
+        int i = ready.top();
+        ready.pop();
+        active |= activatedBy(gates[i]);
+        idx_t qubits = qubitSet(gates[i]);
+        order.push_back(std::move(gates[i]));
+        for (int q = 0; q < numQubits; q++)
+            if ((qubits >> q & 1) && ++head[q] < onQubit[q].size())
+                arrive(onQubit[q][head[q]]);
+    }
+    gates = std::move(order);
+    if (moved > 0)
+        Logger::add("Moved %d gates ahead of qubit activations", moved);
+}
+
+// The initial state is the same for every layout, so the first group is free
+// to put the qubits activated first at the lowest local positions.
+State Compiler::sortByActivation(const State& state, const std::vector<Gate>& groupGates) {
+    int numLocalQubits = numQubits - globalBit;
+    std::vector<size_t> first(numQubits, groupGates.size());
+    for (size_t i = groupGates.size(); i-- > 0;) {
+        idx_t qubits = activatedBy(groupGates[i]);
+        for (int q = 0; q < numQubits; q++)
+            if (qubits >> q & 1)
+                first[q] = i;
+    }
+    std::vector<int> locals(state.layout.begin(), state.layout.begin() + numLocalQubits);
+    std::stable_sort(locals.begin(), locals.end(), [&](int a, int b) { return first[a] < first[b]; });
+    State ret = state;
+    for (int i = 0; i < numLocalQubits; i++) {
+        ret.layout[i] = locals[i];
+        ret.pos[locals[i]] = i;
+    }
+    return ret;
+}
+#endif
+
 Schedule Compiler::run() {
+#ifdef LAZY_ACTIVATION
+    delayActivation();
+#endif
 #if MODE == 2
     bool enableGlobal = false;
 #else
     bool enableGlobal = true;
 #endif
     int inplaceSize = std::min(INPLACE, localSize - 2);
-    SimpleCompiler localCompiler(numQubits, localSize, (idx_t) -1, gates, enableGlobal, 0, (1 << inplaceSize) - 1);
+    // with enableGlobal, only the Pauli frame gates look at localQubits: none of them forces its qubit to be local
+    idx_t localQubits = enableGlobal ? 0 : (idx_t) -1;
+    SimpleCompiler localCompiler(numQubits, localSize, localQubits, gates, enableGlobal, 0, (1 << inplaceSize) - 1);
     LocalGroup localGroup = localCompiler.run();
     auto moveBack = moveToNext(localGroup);
     fillLocals(localGroup);
     Schedule schedule;
     State state(numQubits);
     int numLocalQubits = numQubits - globalBit;
+    int numSweeps = 0, fusedSweeps = 0, superSweeps = 0; // passes over the local state by the fullGroups
     for (size_t id = 0; id < localGroup.fullGroups.size(); id++) {
         auto& gg = localGroup.fullGroups[id];
 
@@ -127,6 +252,10 @@ Schedule Compiler::run() {
         lg.relatedQubits = gg.relatedQubits;
         if (id == 0) {
             state = lg.initFirstGroupState(state, numQubits, newGlobals);
+#ifdef LAZY_ACTIVATION
+            if (!INPLACE)
+                lg.state = state = sortByActivation(state, gg.gates);
+#endif
         } else {
             if (INPLACE) {
                 state = lg.initStateInplace(state, numQubits, newGlobals, overlapGlobals, globalBit);
@@ -148,8 +277,8 @@ Schedule Compiler::run() {
         switch (GPU_BACKEND) {
             case 1: // no break;
             case 2: {
-                lg.overlapGroups = overlapCompiler.run(state, true, false, LOCAL_QUBIT_SIZE, BLAS_MAT_LIMIT, numLocalQubits - globalBit).fullGroups;
-                lg.fullGroups = fullCompiler.run(state, true, false, LOCAL_QUBIT_SIZE, BLAS_MAT_LIMIT, numLocalQubits).fullGroups;
+                lg.overlapGroups = overlapCompiler.run(state, true, false, MyGlobalVars::blockQubits, BLAS_MAT_LIMIT, numLocalQubits - globalBit).fullGroups;
+                lg.fullGroups = fullCompiler.run(state, true, false, MyGlobalVars::blockQubits, BLAS_MAT_LIMIT, numLocalQubits).fullGroups;
                 break;
             }
             case 3: // no break
@@ -159,13 +288,13 @@ Schedule Compiler::run() {
                         UNIMPLEMENTED();
                     }
                 }
-                lg.overlapGroups = overlapCompiler.run(state, false, true, LOCAL_QUBIT_SIZE, BLAS_MAT_LIMIT, numLocalQubits - globalBit).fullGroups;
-                lg.fullGroups = fullCompiler.run(state, false, true, LOCAL_QUBIT_SIZE, BLAS_MAT_LIMIT, numLocalQubits).fullGroups;
+                lg.overlapGroups = overlapCompiler.run(state, false, true, MyGlobalVars::blockQubits, BLAS_MAT_LIMIT, numLocalQubits - globalBit).fullGroups;
+                lg.fullGroups = fullCompiler.run(state, false, true, MyGlobalVars::blockQubits, BLAS_MAT_LIMIT, numLocalQubits).fullGroups;
                 break;
             }
             case 4: {
-                lg.overlapGroups = overlapCompiler.run(state, true, true, LOCAL_QUBIT_SIZE, BLAS_MAT_LIMIT, numLocalQubits - globalBit).fullGroups;
-                lg.fullGroups = fullCompiler.run(state, true, true, LOCAL_QUBIT_SIZE, BLAS_MAT_LIMIT, numLocalQubits).fullGroups;
+                lg.overlapGroups = overlapCompiler.run(state, true, true, MyGlobalVars::blockQubits, BLAS_MAT_LIMIT, numLocalQubits - globalBit).fullGroups;
+                lg.fullGroups = fullCompiler.run(state, true, true, MyGlobalVars::blockQubits, BLAS_MAT_LIMIT, numLocalQubits).fullGroups;
                 break;
             }
             default: {
@@ -173,8 +302,17 @@ Schedule Compiler::run() {
                 break;
             }
         }
+        numSweeps += lg.fullGroups.size();
+#if MODE == 0
+        fusedSweeps += lg.fuseGroups(MyGlobalVars::blockQubits);
+#endif
+#ifdef CPU_L2_QUBITS
+        if (CPU_L2_QUBITS > MyGlobalVars::blockQubits)
+            superSweeps += lg.formSuperGroups(numLocalQubits, MyGlobalVars::blockQubits, CPU_L2_QUBITS);
+#endif
         schedule.localGroups.push_back(std::move(lg));
     }
+    Logger::add("Sweeps: %d (baseline %d, %d fused, %d in super-groups)", numSweeps - fusedSweeps - superSweeps, numSweeps, fusedSweeps, superSweeps);
     schedule.finalState = state;
     return schedule;
 }
@@ -233,6 +371,8 @@ LocalGroup SimpleCompiler::run() {
 
 LocalGroup AdvanceCompiler::run(State& state, bool usePerGate, bool useBLAS, int perGateSize, int blasSize, int cuttSize) {
     assert(usePerGate || useBLAS);
+    // Pauli frame gates on qubits outside localQubits need no related qubit
+    idx_t perGateLocals = enableGlobal ? localQubits : (idx_t) -1;
     LocalGroup lg;
     lg.relatedQubits = 0;
     int cnt = 0;
@@ -292,7 +432,7 @@ LocalGroup AdvanceCompiler::run(State& state, bool usePerGate, bool useBLAS, int
             fillRelated(related, state.layout);
             full = 0;
             cacheRelated = related[0];
-            ggIdx = getGroupOpt(full, related, true && enableGlobal, perGateSize, -1ll);
+            ggIdx = getGroupOpt(full, related, true && enableGlobal, perGateSize, perGateLocals);
             ggBackend = Backend::PerGate;
         } else if (!usePerGate && useBLAS) {
             memset(related, 0, sizeof(related));
@@ -304,7 +444,7 @@ LocalGroup AdvanceCompiler::run(State& state, bool usePerGate, bool useBLAS, int
         }
         if (ggBackend == Backend::PerGate) {
             for (auto& x: ggIdx)
-                gg.addGate(remainGates[x], -1ll, enableGlobal);
+                gg.addGate(remainGates[x], perGateLocals, enableGlobal);
 #ifdef LOG_EVALUATOR
             Logger::add("perf pergate : %f,", Evaluator::getInstance() -> perfPerGate(numQubits, &gg));
 #endif
@@ -371,6 +511,7 @@ std::vector<int> OneLayerCompiler<MAX_GATES>::getGroupOpt(idx_t full, idx_t rela
                     new_cur[id] = 1;
                     for (auto q: gate.controlQubits) {
                         cur[q] = new_cur;
+                        related[q] = newRelated;
                     }
                     cur[t]= new_cur;
                     related[t] = newRelated;
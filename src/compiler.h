@@ -10,9 +10,19 @@ class Compiler {
 public:
     Compiler(int numQubits, std::vector<Gate> inputGates, int globalBits);
     Schedule run();
+    // Removes the SWAP gates and relabels the qubits of the gates after each
+    // one instead. Returns the map from the qubits of the circuit to the
+    // qubits of the remaining gates (pos) and back (layout).
+    static State absorbSwaps(std::vector<Gate>& gates, int numQubits);
 private:
     void fillLocals(LocalGroup& lg);
     std::vector<std::pair<std::vector<Gate>, idx_t>> moveToNext(LocalGroup& lg);
+#ifdef LAZY_ACTIVATION
+    // reorder the gates so that qubits leave |0> as late as the dependencies allow
+    void delayActivation();
+    // local positions of the first group in the order its qubits leave |0>
+    State sortByActivation(const State& state, const std::vector<Gate>& groupGates);
+#endif
     int numQubits;
     int globalBit;
     int localSize;
@@ -1,5 +1,6 @@
 #include "cpu_executor.h"
 #include "cpu/header.h"
+#include "cpu/kernel.h"
 #include <omp.h>
 #include <cstring>
 #include <assert.h>
@@ -7,9 +8,16 @@
 
 namespace CpuImpl {
 
+CpuLowering::CpuLowering(int numQubits, Schedule& schedule): Lowering(numQubits, schedule) {}
+
 CpuExecutor::CpuExecutor(std::vector<cpx*> deviceStateVec, int numQubits, Schedule& schedule): Executor(deviceStateVec, numQubits, schedule) {}
 
+// With AOSOA_LAYOUT, the state is converted to interleaved cpx before the hptt
+// transpose and back to blocks once all2all / inplaceAll2All has finished.
 void CpuExecutor::transpose(std::vector<std::shared_ptr<hptt::Transpose<cpx>>> plans) {
+#ifdef AOSOA_LAYOUT
+    fromAoSoA(deviceStateVec[0], idx_t(1) << (numQubits - MyGlobalVars::bit));
+#endif
     plans[0]->setInputPtr(deviceStateVec[0]);
     plans[0]->setOutputPtr(deviceBuffer[0]);
     plans[0]->execute();
@@ -88,720 +96,96 @@ void CpuExecutor::all2all(int commSize, std::vector<int> comm) {
 #ifndef ENABLE_OVERLAP
     this->eventBarrierAll();
 #endif
+#ifdef AOSOA_LAYOUT
+    toAoSoA(deviceStateVec[0], numElements);
+#endif
 }
 
 #define FOLLOW_NEXT(TYPE) \
 case GateType::TYPE: // no break
 
-#if GPU_BACKEND==1
+#if GPU_BACKEND == 1 || GPU_BACKEND == 3 || GPU_BACKEND == 4 || GPU_BACKEND == 5
 
-inline void fetch_data(value_t* local_real, value_t* local_imag, const cpx* deviceStateVec, int bias, idx_t relatedQubits) {
-    int x;
-    unsigned int y;
-    idx_t mask = (1 << COALESCE_GLOBAL) - 1;
-    assert((relatedQubits & mask) == mask);
-    relatedQubits -= mask;
-    for (x = (1 << LOCAL_QUBIT_SIZE) - 1 - mask, y = relatedQubits; x >= 0; x -= (1 << COALESCE_GLOBAL), y = relatedQubits & (y-1)) {
-        #pragma ivdep
-        for (int i = 0; i < (1 << COALESCE_GLOBAL); i++) {
-            local_real[x + i] = deviceStateVec[(bias | y) + i].real();
-            local_imag[x + i] = deviceStateVec[(bias | y) + i].imag();
-            // printf("fetch %d <- %d\n", x + i, (bias | y) + i);
-        }
-    }
+void CpuExecutor::launchPerGateGroup(std::vector<Gate>& gates, KernelGate hostGates[], const State& state, idx_t relatedQubits, int numLocalQubits) {
+    kernels.svGroup(deviceStateVec[0], hostGates, gates.size(), relatedQubits, numLocalQubits, MyGlobalVars::blockQubits);
 }
 
-inline void save_data(cpx* deviceStateVec, const value_t* local_real, const value_t* local_imag, int bias, idx_t relatedQubits) {
-    int x;
-    unsigned int y;
-    idx_t mask = (1 << COALESCE_GLOBAL) - 1;
-    assert((relatedQubits & mask) == mask);
-    relatedQubits -= mask;
-    for (x = (1 << LOCAL_QUBIT_SIZE) - 1 - mask, y = relatedQubits; x >= 0; x -= (1 << COALESCE_GLOBAL), y = relatedQubits & (y-1)) {
-        #pragma ivdep
-        for (int i = 0; i < (1 << COALESCE_GLOBAL); i++) {
-            deviceStateVec[(bias | y) + i].real(local_real[x + i]);
-            deviceStateVec[(bias | y) + i].imag(local_imag[x + i]);
-        }
-    }
+#ifdef CPU_BIAS_TABLE
+void CpuLowering::lowerPerGateGroup(GateGroup& gg) {
+    Lowering::lowerPerGateGroup(gg);
+    if (!gg.kernelGates.empty())
+        block_bias_table(gg.blockBias, gg.phyRelatedQubits, gg.activeQubits, MyGlobalVars::blockQubits);
 }
 
-inline void apply_gate_group(value_t* local_real, value_t* local_imag, int numGates, int blockID, KernelGate hostGates[]) {
-    for (int i = 0; i < numGates; i++) {
-        auto& gate = hostGates[i];
-        int controlQubit = gate.controlQubit;
-        int targetQubit = gate.targetQubit;
-        char controlIsGlobal = gate.controlIsGlobal;
-        char targetIsGlobal = gate.targetIsGlobal;
-        if (controlQubit == -2) { // mcGate
-            UNIMPLEMENTED();
-        } else if (controlQubit == -3) {
-            if (!controlIsGlobal && !targetIsGlobal) {
-                int m = 1 << (LOCAL_QUBIT_SIZE - 2);
-                int low_bit = std::min((int) gate.encodeQubit, targetQubit);
-                int high_bit = std::max((int) gate.encodeQubit, targetQubit);
-                #ifdef USE_AVX512
-                __m256i mask_inner = _mm256_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 2)) - (1 << low_bit));
-                __m256i mask_outer = _mm256_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << high_bit));
-                __m256i ctr_flag = _mm256_set1_epi32(1 << gate.encodeQubit);
-                __m256i tar_flag = _mm256_set1_epi32(1 << targetQubit);
-                __m256i idx = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
-                const __m256i inc = _mm256_set1_epi32(8);
-                for (int j = 0; j < m; j += 8) {
-                    __m256i lo = _mm256_add_epi32(idx, _mm256_and_si256(idx, mask_inner));
-                    lo = _mm256_add_epi32(lo, _mm256_and_si256(lo, mask_outer));
-                    __m256i s00 = lo;
-                    __m256i s01 = _mm256_add_epi32(s00, tar_flag);
-                    __m256i s10 = _mm256_add_epi32(s00, ctr_flag);
-                    __m256i s11 = _mm256_or_si256(s01, s10);
-
-                    __m512d v00_real = _mm512_i32gather_pd(s00, local_real, 8);
-                    __m512d v00_imag = _mm512_i32gather_pd(s00, local_imag, 8);
-                    __m512d v11_real = _mm512_i32gather_pd(s11, local_real, 8);
-                    __m512d v11_imag = _mm512_i32gather_pd(s11, local_imag, 8);
-                    __m512d r00 = _mm512_set1_pd(gate.r00);
-                    __m512d i00 = _mm512_set1_pd(gate.i00);
-                    __m512d r11 = _mm512_set1_pd(gate.r11);
-                    __m512d i11 = _mm512_set1_pd(gate.i11);
-                    __m512d v00_real_new = _mm512_fnmadd_pd(v00_imag, i00, _mm512_mul_pd(v00_real, r00));
-                    v00_real_new = _mm512_fnmadd_pd(v11_imag, i11, _mm512_fmadd_pd(v11_real, r11, v00_real_new));
-                    __m512d v00_imag_new = _mm512_fmadd_pd(v00_imag, r00, _mm512_mul_pd(v00_real, i00));
-                    v00_imag_new = _mm512_fmadd_pd(v11_imag, r11, _mm512_fmadd_pd(v11_real, i11, v00_imag_new));
-                    _mm512_i32scatter_pd(local_real, s00, v00_real_new, 8);
-                    _mm512_i32scatter_pd(local_imag, s00, v00_imag_new, 8);
-                    __m512d v11_real_new = _mm512_fnmadd_pd(v11_imag, i00, _mm512_mul_pd(v11_real, r00));
-                    v11_real_new = _mm512_fnmadd_pd(v00_imag, i11, _mm512_fmadd_pd(v00_real, r11, v11_real_new));
-                    __m512d v11_imag_new = _mm512_fmadd_pd(v11_imag, r00, _mm512_mul_pd(v11_real, i00));
-                    v11_imag_new = _mm512_fmadd_pd(v00_imag, r11, _mm512_fmadd_pd(v00_real, i11, v11_imag_new));
-                    _mm512_i32scatter_pd(local_real, s11, v11_real_new, 8);
-                    _mm512_i32scatter_pd(local_imag, s11, v11_imag_new, 8);
-
-                    __m512d v01_real = _mm512_i32gather_pd(s01, local_real, 8);
-                    __m512d v01_imag = _mm512_i32gather_pd(s01, local_imag, 8);
-                    __m512d v10_real = _mm512_i32gather_pd(s10, local_real, 8);
-                    __m512d v10_imag = _mm512_i32gather_pd(s10, local_imag, 8);
-                    __m512d r01 = _mm512_set1_pd(gate.r01);
-                    __m512d i01 = _mm512_set1_pd(gate.i01);
-                    __m512d r10 = _mm512_set1_pd(gate.r10);
-                    __m512d i10 = _mm512_set1_pd(gate.i10);
-                    __m512d v01_real_new = _mm512_fnmadd_pd(v01_imag, i01, _mm512_mul_pd(v01_real, r01));
-                    v01_real_new = _mm512_fnmadd_pd(v10_imag, i10, _mm512_fmadd_pd(v10_real, r10, v01_real_new));
-                    __m512d v01_imag_new = _mm512_fmadd_pd(v01_imag, r01, _mm512_mul_pd(v01_real, i01));
-                    v01_imag_new = _mm512_fmadd_pd(v10_imag, r10, _mm512_fmadd_pd(v10_real, i10, v01_imag_new));
-                    _mm512_i32scatter_pd(local_real, s01, v01_real_new, 8);
-                    _mm512_i32scatter_pd(local_imag, s01, v01_imag_new, 8);
-                    __m512d v10_real_new = _mm512_fnmadd_pd(v10_imag, i01, _mm512_mul_pd(v10_real, r01));
-                    v10_real_new = _mm512_fnmadd_pd(v01_imag, i10, _mm512_fmadd_pd(v01_real, r10, v10_real_new));
-                    __m512d v10_imag_new = _mm512_fmadd_pd(v10_imag, r01, _mm512_mul_pd(v10_real, i01));
-                    v10_imag_new = _mm512_fmadd_pd(v01_imag, r10, _mm512_fmadd_pd(v01_real, i10, v10_imag_new));
-                    _mm512_i32scatter_pd(local_real, s10, v10_real_new, 8);
-                    _mm512_i32scatter_pd(local_imag, s10, v10_imag_new, 8);
-
-                    idx = _mm256_add_epi32(idx, inc);
-                }
-                #elif defined(USE_AVX2)
-                __m128i mask_inner = _mm_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 2)) - (1 << low_bit));
-                __m128i mask_outer = _mm_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << high_bit));
-                __m128i ctr_flag = _mm_set1_epi32(1 << gate.encodeQubit);
-                __m128i tar_flag = _mm_set1_epi32(1 << targetQubit);
-                __m128i idx = _mm_set_epi32(0, 1, 2, 3);
-                const __m128i inc = _mm_set1_epi32(4);
-                for (int j = 0; j < m; j += 4) {
-                    __m128i lo = _mm_add_epi32(idx, _mm_and_si128(idx, mask_inner));
-                    lo = _mm_add_epi32(lo, _mm_and_si128(lo, mask_outer));
-                    __m128i s00 = lo;
-                    __m128i s01 = _mm_add_epi32(s00, tar_flag);
-                    __m128i s10 = _mm_add_epi32(s00, ctr_flag);
-                    __m128i s11 = _mm_or_si128(s01, s10);
-
-                    __m256d v00_real = _mm256_i32gather_pd(local_real, s00, 8);
-                    __m256d v00_imag = _mm256_i32gather_pd(local_imag, s00, 8);
-                    __m256d v11_real = _mm256_i32gather_pd(local_real, s11, 8);
-                    __m256d v11_imag = _mm256_i32gather_pd(local_imag, s11, 8);
-                    __m256d r00 = _mm256_set1_pd(gate.r00);
-                    __m256d i00 = _mm256_set1_pd(gate.i00);
-                    __m256d r11 = _mm256_set1_pd(gate.r11);
-                    __m256d i11 = _mm256_set1_pd(gate.i11);
-                    __m256d v00_real_new = _mm256_fnmadd_pd(v00_imag, i00, _mm256_mul_pd(v00_real, r00));
-                    v00_real_new = _mm256_fnmadd_pd(v11_imag, i11, _mm256_fmadd_pd(v11_real, r11, v00_real_new));
-                    __m256d v00_imag_new = _mm256_fmadd_pd(v00_imag, r00, _mm256_mul_pd(v00_real, i00));
-                    v00_imag_new = _mm256_fmadd_pd(v11_imag, r11, _mm256_fmadd_pd(v11_real, i11, v00_imag_new));
-                    _mm256_i32scatter_pd(local_real, s00, v00_real_new, 8);
-                    _mm256_i32scatter_pd(local_imag, s00, v00_imag_new, 8);
-                    __m256d v11_real_new = _mm256_fnmadd_pd(v11_imag, i00, _mm256_mul_pd(v11_real, r00));
-                    v11_real_new = _mm256_fnmadd_pd(v00_imag, i11, _mm256_fmadd_pd(v00_real, r11, v11_real_new));
-                    __m256d v11_imag_new = _mm256_fmadd_pd(v11_imag, r00, _mm256_mul_pd(v11_real, i00));
-                    v11_imag_new = _mm256_fmadd_pd(v00_imag, r11, _mm256_fmadd_pd(v00_real, i11, v11_imag_new));
-                    _mm256_i32scatter_pd(local_real, s11, v11_real_new, 8);
-                    _mm256_i32scatter_pd(local_imag, s11, v11_imag_new, 8);
-
-                    __m256d v01_real = _mm256_i32gather_pd(local_real, s01, 8);
-                    __m256d v01_imag = _mm256_i32gather_pd(local_imag, s01, 8);
-                    __m256d v10_real = _mm256_i32gather_pd(local_real, s10, 8);
-                    __m256d v10_imag = _mm256_i32gather_pd(local_imag, s10, 8);
-                    __m256d r01 = _mm256_set1_pd(gate.r01);
-                    __m256d i01 = _mm256_set1_pd(gate.i01);
-                    __m256d r10 = _mm256_set1_pd(gate.r10);
-                    __m256d i10 = _mm256_set1_pd(gate.i10);
-                    __m256d v01_real_new = _mm256_fnmadd_pd(v01_imag, i01, _mm256_mul_pd(v01_real, r01));
-                    v01_real_new = _mm256_fnmadd_pd(v10_imag, i10, _mm256_fmadd_pd(v10_real, r10, v01_real_new));
-                    __m256d v01_imag_new = _mm256_fmadd_pd(v01_imag, r01, _mm256_mul_pd(v01_real, i01));
-                    v01_imag_new = _mm256_fmadd_pd(v10_imag, r10, _mm256_fmadd_pd(v10_real, i10, v01_imag_new));
-                    _mm256_i32scatter_pd(local_real, s01, v01_real_new, 8);
-                    _mm256_i32scatter_pd(local_imag, s01, v01_imag_new, 8);
-                    __m256d v10_real_new = _mm256_fnmadd_pd(v10_imag, i01, _mm256_mul_pd(v10_real, r01));
-                    v10_real_new = _mm256_fnmadd_pd(v01_imag, i10, _mm256_fmadd_pd(v01_real, r10, v10_real_new));
-                    __m256d v10_imag_new = _mm256_fmadd_pd(v10_imag, r01, _mm256_mul_pd(v10_real, i01));
-                    v10_imag_new = _mm256_fmadd_pd(v01_imag, r10, _mm256_fmadd_pd(v01_real, i10, v10_imag_new));
-                    _mm256_i32scatter_pd(local_real, s10, v10_real_new, 8);
-                    _mm256_i32scatter_pd(local_imag, s10, v10_imag_new, 8);
-
-                    idx = _mm_add_epi32(idx, inc);
-                }
-                #else
-                int mask_inner = (1 << (LOCAL_QUBIT_SIZE - 2)) - (1 << low_bit);
-                int mask_outer = (1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << high_bit);
-                for (int j = 0; j < m; j++) {
-                    int lo = j + (j & mask_inner);
-                    lo = lo + (lo & mask_outer);
-                    int s00 = lo;
-                    int s01 = s00 | 1 << targetQubit;
-                    int s10 = s00 | 1 << gate.encodeQubit;
-                    int s11 = s01 | s10;
-                    cpx v00 = cpx(local_real[s00], local_imag[s00]);
-                    cpx v11 = cpx(local_real[s11], local_imag[s11]);
-                    cpx n00 = v00 * cpx(gate.r00, gate.i00) + v11 * cpx(gate.r11, gate.i11);
-                    cpx n11 = v11 * cpx(gate.r00, gate.i00) + v00 * cpx(gate.r11, gate.i11);
-                    local_real[s00] = n00.real();
-                    local_imag[s00] = n00.imag();
-                    local_real[s11] = n11.real();
-                    local_imag[s11] = n11.imag();
-                    cpx v01 = cpx(local_real[s01], local_imag[s01]);
-                    cpx v10 = cpx(local_real[s10], local_imag[s10]);
-                    cpx n01 = v01 * cpx(gate.r01, gate.i01) + v10 * cpx(gate.r10, gate.i10);
-                    cpx n10 = v10 * cpx(gate.r01, gate.i01) + v01 * cpx(gate.r10, gate.i10);
-                    local_real[s01] = n01.real();
-                    local_imag[s01] = n01.imag();
-                    local_real[s10] = n10.real();
-                    local_imag[s10] = n10.imag();
-                }
-                #endif
-            } else if (controlIsGlobal && !targetIsGlobal) {
-                bool isHighBlock = (blockID >> gate.encodeQubit) & 1;
-                int m = 1 << (LOCAL_QUBIT_SIZE - 1);
-                #ifdef USE_AVX512
-                __m256i mask_inner = _mm256_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << gate.targetQubit));
-                __m256i tar_flag = _mm256_set1_epi32(1 << targetQubit);
-                __m256i idx = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
-                const __m256i inc = _mm256_set1_epi32(8);
-                if (!isHighBlock){
-                    for (int j = 0; j < m; j += 8) {
-                        __m256i lo = _mm256_add_epi32(idx, _mm256_and_si256(idx, mask_inner));
-                        __m512d lo_real = _mm512_i32gather_pd(lo, local_real, 8);
-                        __m512d lo_imag = _mm512_i32gather_pd(lo, local_imag, 8);
-                        __m512d r00 = _mm512_set1_pd(gate.r00);
-                        __m512d i00 = _mm512_set1_pd(gate.i00);
-                        __m512d lo_real_new = _mm512_fnmadd_pd(lo_imag, i00, _mm512_mul_pd(lo_real, r00));
-                        _mm512_i32scatter_pd(local_real, lo, lo_real_new, 8);
-                        __m512d lo_imag_new = _mm512_fmadd_pd(lo_imag, r00, _mm512_mul_pd(lo_real, i00));
-                        _mm512_i32scatter_pd(local_imag, lo, lo_imag_new, 8);
-
-                        __m256i hi = _mm256_add_epi32(lo, tar_flag);
-                        __m512d hi_real = _mm512_i32gather_pd(hi, local_real, 8);
-                        __m512d hi_imag = _mm512_i32gather_pd(hi, local_imag, 8);
-                        __m512d r01 = _mm512_set1_pd(gate.r01);
-                        __m512d i01 = _mm512_set1_pd(gate.i01);
-                        __m512d hi_real_new = _mm512_fnmadd_pd(hi_imag, i01, _mm512_mul_pd(hi_real, r01));
-                        _mm512_i32scatter_pd(local_real, hi, hi_real_new, 8);
-                        __m512d hi_imag_new = _mm512_fmadd_pd(hi_imag, r01, _mm512_mul_pd(hi_real, i01));
-                        _mm512_i32scatter_pd(local_imag, hi, hi_imag_new, 8);
-
-                        idx = _mm256_add_epi32(idx, inc);
-                    }
-                } else {
-                    for (int j = 0; j < m; j += 8) {
-                        __m256i lo = _mm256_add_epi32(idx, _mm256_and_si256(idx, mask_inner));
-                        __m512d lo_real = _mm512_i32gather_pd(lo, local_real, 8);
-                        __m512d lo_imag = _mm512_i32gather_pd(lo, local_imag, 8);
-                        __m512d r01 = _mm512_set1_pd(gate.r01);
-                        __m512d i01 = _mm512_set1_pd(gate.i01);
-                        __m512d lo_real_new = _mm512_fnmadd_pd(lo_imag, i01, _mm512_mul_pd(lo_real, r01));
-                        _mm512_i32scatter_pd(local_real, lo, lo_real_new, 8);
-                        __m512d lo_imag_new = _mm512_fmadd_pd(lo_imag, r01, _mm512_mul_pd(lo_real, i01));
-                        _mm512_i32scatter_pd(local_imag, lo, lo_imag_new, 8);
-
-                        __m256i hi = _mm256_add_epi32(lo, tar_flag);
-                        __m512d hi_real = _mm512_i32gather_pd(hi, local_real, 8);
-                        __m512d hi_imag = _mm512_i32gather_pd(hi, local_imag, 8);
-                        __m512d r00 = _mm512_set1_pd(gate.r00);
-                        __m512d i00 = _mm512_set1_pd(gate.i00);
-                        __m512d hi_real_new = _mm512_fnmadd_pd(hi_imag, i00, _mm512_mul_pd(hi_real, r00));
-                        _mm512_i32scatter_pd(local_real, hi, hi_real_new, 8);
-                        __m512d hi_imag_new = _mm512_fmadd_pd(hi_imag, r00, _mm512_mul_pd(hi_real, i00));
-                        _mm512_i32scatter_pd(local_imag, hi, hi_imag_new, 8);
-
-                        idx = _mm256_add_epi32(idx, inc);
-
-                    }
-                }
-                #elif defined(USE_AVX2)
-                __m128i mask_inner = _mm_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << gate.targetQubit));
-                __m128i tar_flag = _mm_set1_epi32(1 << targetQubit);
-                __m128i idx = _mm_set_epi32(0, 1, 2, 3);
-                const __m128i inc = _mm_set1_epi32(4);
-                if (!isHighBlock){
-                    for (int j = 0; j < m; j += 4) {
-                        __m128i lo = _mm_add_epi32(idx, _mm_and_si128(idx, mask_inner));
-                        __m256d lo_real = _mm256_i32gather_pd(local_real, lo, 8);
-                        __m256d lo_imag = _mm256_i32gather_pd(local_imag, lo, 8);
-                        __m256d r00 = _mm256_set1_pd(gate.r00);
-                        __m256d i00 = _mm256_set1_pd(gate.i00);
-                        __m256d lo_real_new = _mm256_fnmadd_pd(lo_imag, i00, _mm256_mul_pd(lo_real, r00));
-                        _mm256_i32scatter_pd(local_real, lo, lo_real_new, 8);
-                        __m256d lo_imag_new = _mm256_fmadd_pd(lo_imag, r00, _mm256_mul_pd(lo_real, i00));
-                        _mm256_i32scatter_pd(local_imag, lo, lo_imag_new, 8);
-
-                        __m128i hi = _mm_add_epi32(lo, tar_flag);
-                        __m256d hi_real = _mm256_i32gather_pd(local_real, hi, 8);
-                        __m256d hi_imag = _mm256_i32gather_pd(local_imag, hi, 8);
-                        __m256d r01 = _mm256_set1_pd(gate.r01);
-                        __m256d i01 = _mm256_set1_pd(gate.i01);
-                        __m256d hi_real_new = _mm256_fnmadd_pd(hi_imag, i01, _mm256_mul_pd(hi_real, r01));
-                        _mm256_i32scatter_pd(local_real, hi, hi_real_new, 8);
-                        __m256d hi_imag_new = _mm256_fmadd_pd(hi_imag, r01, _mm256_mul_pd(hi_real, i01));
-                        _mm256_i32scatter_pd(local_imag, hi, hi_imag_new, 8);
-
-                        idx = _mm_add_epi32(idx, inc);
-                    }
-                } else {
-                    for (int j = 0; j < m; j += 4) {
-                        __m128i lo = _mm_add_epi32(idx, _mm_and_si128(idx, mask_inner));
-                        __m256d lo_real = _mm256_i32gather_pd(local_real, lo, 8);
-                        __m256d lo_imag = _mm256_i32gather_pd(local_imag, lo, 8);
-                        __m256d r01 = _mm256_set1_pd(gate.r01);
-                        __m256d i01 = _mm256_set1_pd(gate.i01);
-                        __m256d lo_real_new = _mm256_fnmadd_pd(lo_imag, i01, _mm256_mul_pd(lo_real, r01));
-                        _mm256_i32scatter_pd(local_real, lo, lo_real_new, 8);
-                        __m256d lo_imag_new = _mm256_fmadd_pd(lo_imag, r01, _mm256_mul_pd(lo_real, i01));
-                        _mm256_i32scatter_pd(local_imag, lo, lo_imag_new, 8);
+void CpuExecutor::applyPerGateGroup(GateGroup& gg) {
+    if (gg.blockBias.empty()) {
+        Executor::applyPerGateGroup(gg);
+        return;
+    }
+    globalPhase[0] *= gg.globalPhase[0];
+    kernels.svGroupTable(deviceStateVec[0], gg.kernelGates.data(), gg.gates.size(), gg.phyRelatedQubits, gg.blockBias.data(), gg.activeQubits, MyGlobalVars::blockQubits);
+}
+#endif
 
-                        __m128i hi = _mm_add_epi32(lo, tar_flag);
-                        __m256d hi_real = _mm256_i32gather_pd(local_real, hi, 8);
-                        __m256d hi_imag = _mm256_i32gather_pd(local_imag, hi, 8);
-                        __m256d r00 = _mm256_set1_pd(gate.r00);
-                        __m256d i00 = _mm256_set1_pd(gate.i00);
-                        __m256d hi_real_new = _mm256_fnmadd_pd(hi_imag, i00, _mm256_mul_pd(hi_real, r00));
-                        _mm256_i32scatter_pd(local_real, hi, hi_real_new, 8);
-                        __m256d hi_imag_new = _mm256_fmadd_pd(hi_imag, r00, _mm256_mul_pd(hi_real, i00));
-                        _mm256_i32scatter_pd(local_imag, hi, hi_imag_new, 8);
+#ifdef CPU_L2_QUBITS
+void CpuLowering::lowerSuperGroup(GateGroup* groups, int numGroups) {
+    // local qubits from position activeQubits on are lowered as global qubits of value 0
+    int numLocalQubits = groups[0].activeQubits;
+    int inactive = numQubits - MyGlobalVars::bit - numLocalQubits;
+    idx_t tileLogicQb = 0;
+    for (int i = 0; i < numGroups; i++)
+        tileLogicQb |= groups[i].blockQubitSet(numLocalQubits, MyGlobalVars::blockQubits);
+    idx_t tileQubits = toPhyQubitSet(tileLogicQb);
+    // every thread works on tiles of its own
+    if ((idx_t(1) << (numLocalQubits - bitCount(tileQubits))) < idx_t(omp_get_max_threads())) {
+        groups[0].tileQubits = 0;
+        Lowering::lowerSuperGroup(groups, numGroups);
+        return;
+    }
 
-                        idx = _mm_add_epi32(idx, inc);
-                    }
-                }
-                #else
-                int mask_inner = (1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << targetQubit);
-                if (!isHighBlock){
-                    #pragma ivdep
-                    for (int j = 0; j < m; j++) {
-                        int lo = j + (j & mask_inner);
-                        int hi = lo + (1 << targetQubit);
-                        cpx new_lo = cpx(local_real[lo], local_imag[lo]) * cpx(gate.r00, gate.i00);
-                        local_real[lo] = new_lo.real();
-                        local_imag[lo] = new_lo.imag();
-                        cpx new_hi = cpx(local_real[hi], local_imag[hi]) * cpx(gate.r01, gate.i01);
-                        local_real[hi] = new_hi.real();
-                        local_imag[hi] = new_hi.imag();
-                    }
-                } else {
-                    #pragma ivdep
-                    for (int j = 0; j < m; j++) {
-                        int lo = j + (j & mask_inner);
-                        int hi = lo + (1 << targetQubit);
-                        cpx new_lo = cpx(local_real[lo], local_imag[lo]) * cpx(gate.r01, gate.i01);
-                        local_real[lo] = new_lo.real();
-                        local_imag[lo] = new_lo.imag();
-                        cpx new_hi = cpx(local_real[hi], local_imag[hi]) * cpx(gate.r00, gate.i00);
-                        local_real[hi] = new_hi.real();
-                        local_imag[hi] = new_hi.imag();
-                    }
-                }
-                #endif
-            } else {
-                UNIMPLEMENTED();
-            }
-        } else if (!controlIsGlobal) {
-            if (!targetIsGlobal) {
-                int m = 1 << (LOCAL_QUBIT_SIZE - 2);
-                int low_bit = std::min(controlQubit, targetQubit);
-                int high_bit = std::max(controlQubit, targetQubit);
-                // TODO: switch (gate)
-                #ifdef USE_AVX512
-                __m256i mask_inner = _mm256_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 2)) - (1 << low_bit));
-                __m256i mask_outer = _mm256_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << high_bit));
-                __m256i ctr_flag = _mm256_set1_epi32(1 << controlQubit);
-                __m256i tar_flag = _mm256_set1_epi32(1 << targetQubit);
-                assert(m % 8 == 0);
-                __m256i idx = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
-                const __m256i inc = _mm256_set1_epi32(8);
-                for (int j = 0; j < m; j += 8) {
-                    __m256i lo = _mm256_add_epi32(idx, _mm256_and_si256(idx, mask_inner));
-                    lo = _mm256_add_epi32(lo, _mm256_and_si256(lo, mask_outer));
-                    lo = _mm256_add_epi32(lo, ctr_flag);
-                    __m256i hi = _mm256_add_epi32(lo, tar_flag);
-                    // lo = _mm256_add_epi32(lo, lo);
-                    // hi = _mm256_add_epi32(hi, hi);
-                    __m512d lo_real = _mm512_i32gather_pd(lo, local_real, 8);
-                    __m512d lo_imag = _mm512_i32gather_pd(lo, local_imag, 8);
-                    __m512d hi_real = _mm512_i32gather_pd(hi, local_real, 8);
-                    __m512d hi_imag = _mm512_i32gather_pd(hi, local_imag, 8);
-                    __m512d r00 = _mm512_set1_pd(gate.r00);
-                    __m512d i00 = _mm512_set1_pd(gate.i00);
-                    __m512d r01 = _mm512_set1_pd(gate.r01);
-                    __m512d i01 = _mm512_set1_pd(gate.i01);
-                    __m512d lo_real_new = _mm512_fnmadd_pd(lo_imag, i00, _mm512_mul_pd(lo_real, r00));
-                    lo_real_new = _mm512_fnmadd_pd(hi_imag, i01, _mm512_fmadd_pd(hi_real, r01, lo_real_new));
-                    __m512d lo_imag_new = _mm512_fmadd_pd(lo_imag, r00, _mm512_mul_pd(lo_real, i00));
-                    lo_imag_new = _mm512_fmadd_pd(hi_imag, r01, _mm512_fmadd_pd(hi_real, i01, lo_imag_new));
-                    _mm512_i32scatter_pd(local_real, lo, lo_real_new, 8);
-                    _mm512_i32scatter_pd(local_imag, lo, lo_imag_new, 8);
-                    __m512d r10 = _mm512_set1_pd(gate.r10);
-                    __m512d i10 = _mm512_set1_pd(gate.i10);
-                    __m512d hi_real_new = _mm512_fnmadd_pd(lo_imag, i10, _mm512_mul_pd(lo_real, r10));
-                    __m512d r11 = _mm512_set1_pd(gate.r11);
-                    __m512d i11 = _mm512_set1_pd(gate.i11);
-                    hi_real_new = _mm512_fnmadd_pd(hi_imag, i11, _mm512_fmadd_pd(hi_real, r11, hi_real_new));
-                    __m512d hi_imag_new = _mm512_fmadd_pd(lo_imag, r10, _mm512_mul_pd(lo_real, i10));
-                    hi_imag_new = _mm512_fmadd_pd(hi_imag, r11, _mm512_fmadd_pd(hi_real, i11, hi_imag_new));
-                    _mm512_i32scatter_pd(local_real, hi, hi_real_new, 8);
-                    _mm512_i32scatter_pd(local_imag, hi, hi_imag_new, 8);
-                    idx = _mm256_add_epi32(idx, inc);
-                }
-                #elif defined(USE_AVX2)
-                __m128i mask_inner = _mm_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 2)) - (1 << low_bit));
-                __m128i mask_outer = _mm_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << high_bit));
-                __m128i ctr_flag = _mm_set1_epi32(1 << controlQubit);
-                __m128i tar_flag = _mm_set1_epi32(1 << targetQubit);
-                assert(m % 8 == 0);
-                __m128i idx = _mm_set_epi32(0, 1, 2, 3);
-                const __m128i inc = _mm_set1_epi32(4);
-                for (int j = 0; j < m; j += 4) {
-                    __m128i lo = _mm_add_epi32(idx, _mm_and_si128(idx, mask_inner));
-                    lo = _mm_add_epi32(lo, _mm_and_si128(lo, mask_outer));
-                    lo = _mm_add_epi32(lo, ctr_flag);
-                    __m128i hi = _mm_add_epi32(lo, tar_flag);
-                    // lo = _mm_add_epi32(lo, lo);
-                    // hi = _mm_add_epi32(hi, hi);
-                    __m256d lo_real = _mm256_i32gather_pd(local_real, lo, 8);
-                    __m256d lo_imag = _mm256_i32gather_pd(local_imag, lo, 8);
-                    __m256d hi_real = _mm256_i32gather_pd(local_real, hi, 8);
-                    __m256d hi_imag = _mm256_i32gather_pd(local_imag, hi, 8);
-                    __m256d r00 = _mm256_set1_pd(gate.r00);
-                    __m256d i00 = _mm256_set1_pd(gate.i00);
-                    __m256d r01 = _mm256_set1_pd(gate.r01);
-                    __m256d i01 = _mm256_set1_pd(gate.i01);
-                    __m256d lo_real_new = _mm256_fnmadd_pd(lo_imag, i00, _mm256_mul_pd(lo_real, r00));
-                    lo_real_new = _mm256_fnmadd_pd(hi_imag, i01, _mm256_fmadd_pd(hi_real, r01, lo_real_new));
-                    __m256d lo_imag_new = _mm256_fmadd_pd(lo_imag, r00, _mm256_mul_pd(lo_real, i00));
-                    lo_imag_new = _mm256_fmadd_pd(hi_imag, r01, _mm256_fmadd_pd(hi_real, i01, lo_imag_new));
-                    _mm256_i32scatter_pd(local_real, lo, lo_real_new, 8);
-                    _mm256_i32scatter_pd(local_imag, lo, lo_imag_new, 8);
-                    __m256d r10 = _mm256_set1_pd(gate.r10);
-                    __m256d i10 = _mm256_set1_pd(gate.i10);
-                    __m256d hi_real_new = _mm256_fnmadd_pd(lo_imag, i10, _mm256_mul_pd(lo_real, r10));
-                    __m256d r11 = _mm256_set1_pd(gate.r11);
-                    __m256d i11 = _mm256_set1_pd(gate.i11);
-                    hi_real_new = _mm256_fnmadd_pd(hi_imag, i11, _mm256_fmadd_pd(hi_real, r11, hi_real_new));
-                    __m256d hi_imag_new = _mm256_fmadd_pd(lo_imag, r10, _mm256_mul_pd(lo_real, i10));
-                    hi_imag_new = _mm256_fmadd_pd(hi_imag, r11, _mm256_fmadd_pd(hi_real, i11, hi_imag_new));
-                    _mm256_i32scatter_pd(local_real, hi, hi_real_new, 8);
-                    _mm256_i32scatter_pd(local_imag, hi, hi_imag_new, 8);
-                    idx = _mm_add_epi32(idx, inc);
-                }
-                #else
-                int mask_inner = (1 << (LOCAL_QUBIT_SIZE - 2)) - (1 << low_bit);
-                int mask_outer = (1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << high_bit);
-                #pragma ivdep
-                for (int j = 0; j < m; j++) {
-                    int lo = j + (j & mask_inner);
-                    lo = lo + (lo & mask_outer);
-                    lo += 1 << controlQubit;
-                    int hi = lo | (1 << targetQubit);
-                    cpx lo_val = cpx(local_real[lo], local_imag[lo]);
-                    cpx hi_val = cpx(local_real[hi], local_imag[hi]);
-                    cpx lo_val_new = lo_val * cpx(gate.r00, gate.i00) + hi_val * cpx(gate.r01, gate.i01);
-                    local_real[lo] = lo_val_new.real();
-                    local_imag[lo] = lo_val_new.imag();
-                    cpx hi_val_new = lo_val * cpx(gate.r10, gate.i10) + hi_val * cpx(gate.r11, gate.i11);
-                    local_real[hi] = hi_val_new.real();
-                    local_imag[hi] = hi_val_new.imag();
-                }
-                #endif
-            } else {
-                assert(hostGates[i].type == GateType::CZ || hostGates[i].type == GateType::CU1 || hostGates[i].type == GateType::CRZ);
-                bool isHighBlock = (blockID >> targetQubit) & 1;
-                int m = 1 << (LOCAL_QUBIT_SIZE - 1);
-                if (!isHighBlock){
-                    if (hostGates[i].type == GateType::CRZ) {
-                        #ifdef USE_AVX512
-                        __m256i mask_inner = _mm256_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << controlQubit));
-                        __m256i ctr_flag = _mm256_set1_epi32(1 << controlQubit);
-                        __m256i idx = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
-                        const __m256i inc = _mm256_set1_epi32(8);
-                        for (int j = 0; j < m; j += 8) {
-                            __m256i x = _mm256_add_epi32(idx, _mm256_and_si256(idx, mask_inner));
-                            x = _mm256_add_epi32(x, ctr_flag);
-                            __m512d r00 = _mm512_set1_pd(gate.r00);
-                            __m512d i00 = _mm512_set1_pd(gate.i00);
-                            __m512d x_real = _mm512_i32gather_pd(x, local_real, 8);
-                            __m512d x_imag = _mm512_i32gather_pd(x, local_imag, 8);
-                            __m512d x_real_new = _mm512_fnmadd_pd(x_imag, i00, _mm512_mul_pd(x_real, r00));
-                            __m512d x_imag_new = _mm512_fmadd_pd(x_imag, r00, _mm512_mul_pd(x_real, i00));
-                            _mm512_i32scatter_pd(local_real, x, x_real_new, 8);
-                            _mm512_i32scatter_pd(local_imag, x, x_imag_new, 8);
-                            idx = _mm256_add_epi32(idx, inc);
-                        }
-                        #elif defined(USE_AVX2)
-                        __m128i mask_inner = _mm_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << controlQubit));
-                        __m128i ctr_flag = _mm_set1_epi32(1 << controlQubit);
-                        __m128i idx = _mm_set_epi32(0, 1, 2, 3);
-                        const __m128i inc = _mm_set1_epi32(4);
-                        for (int j = 0; j < m; j += 4) {
-                            __m128i x = _mm_add_epi32(idx, _mm_and_si128(idx, mask_inner));
-                            x = _mm_add_epi32(x, ctr_flag);
-                            __m256d r00 = _mm256_set1_pd(gate.r00);
-                            __m256d i00 = _mm256_set1_pd(gate.i00);
-                            __m256d x_real = _mm256_i32gather_pd(local_real, x, 8);
-                            __m256d x_imag = _mm256_i32gather_pd(local_imag, x, 8);
-                            __m256d x_real_new = _mm256_fnmadd_pd(x_imag, i00, _mm256_mul_pd(x_real, r00));
-                            __m256d x_imag_new = _mm256_fmadd_pd(x_imag, r00, _mm256_mul_pd(x_real, i00));
-                            _mm256_i32scatter_pd(local_real, x, x_real_new, 8);
-                            _mm256_i32scatter_pd(local_imag, x, x_imag_new, 8);
-                            idx = _mm_add_epi32(idx, inc);
-                        }
-                        #else
-                        int mask_inner = (1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << controlQubit);
-                        #pragma ivdep
-                        for (int j = 0; j < m; j++) {
-                            int x = j + (j & mask_inner) + (1 << controlQubit);
-                            cpx new_val = cpx(local_real[x], local_imag[x]) * cpx(gate.r00, gate.i00);
-                            local_real[x] = new_val.real();
-                            local_imag[x] = new_val.imag();
-                        }
-                        #endif
-                    }
-                } else {
-                    #ifdef USE_AVX512
-                    __m256i mask_inner = _mm256_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << controlQubit));
-                    __m256i ctr_flag = _mm256_set1_epi32(1 << controlQubit);
-                    __m256i idx = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
-                    const __m256i inc = _mm256_set1_epi32(8);
-                    for (int j = 0; j < m; j += 8) {
-                        __m256i x = _mm256_add_epi32(idx, _mm256_and_si256(idx, mask_inner));
-                        x = _mm256_add_epi32(x, ctr_flag);
-                        __m512d r11 = _mm512_set1_pd(gate.r11);
-                        __m512d i11 = _mm512_set1_pd(gate.i11);
-                        __m512d x_real = _mm512_i32gather_pd(x, local_real, 8);
-                        __m512d x_imag = _mm512_i32gather_pd(x, local_imag, 8);
-                        __m512d x_real_new = _mm512_fnmadd_pd(x_imag, i11, _mm512_mul_pd(x_real, r11));
-                        __m512d x_imag_new = _mm512_fmadd_pd(x_imag, r11, _mm512_mul_pd(x_real, i11));
-                        _mm512_i32scatter_pd(local_real, x, x_real_new, 8);
-                        _mm512_i32scatter_pd(local_imag, x, x_imag_new, 8);
-                        idx = _mm256_add_epi32(idx, inc);
-                    }
-                    #elif defined(USE_AVX2)
-                    __m128i mask_inner = _mm_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << controlQubit));
-                    __m128i ctr_flag = _mm_set1_epi32(1 << controlQubit);
-                    __m128i idx = _mm_set_epi32(0, 1, 2, 3);
-                    const __m128i inc = _mm_set1_epi32(4);
-                    for (int j = 0; j < m; j += 4) {
-                        __m128i x = _mm_add_epi32(idx, _mm_and_si128(idx, mask_inner));
-                        x = _mm_add_epi32(x, ctr_flag);
-                        __m256d r11 = _mm256_set1_pd(gate.r11);
-                        __m256d i11 = _mm256_set1_pd(gate.i11);
-                        __m256d x_real = _mm256_i32gather_pd(local_real, x, 8);
-                        __m256d x_imag = _mm256_i32gather_pd(local_imag, x, 8);
-                        __m256d x_real_new = _mm256_fnmadd_pd(x_imag, i11, _mm256_mul_pd(x_real, r11));
-                        __m256d x_imag_new = _mm256_fmadd_pd(x_imag, r11, _mm256_mul_pd(x_real, i11));
-                        _mm256_i32scatter_pd(local_real, x, x_real_new, 8);
-                        _mm256_i32scatter_pd(local_imag, x, x_imag_new, 8);
-                        idx = _mm_add_epi32(idx, inc);
-                    }
-                    #else
-                    int mask_inner = (1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << controlQubit);
-                    #pragma ivdep
-                    for (int j = 0; j < m; j++) {
-                        int x = j + (j & mask_inner) + (1 << controlQubit);
-                        cpx new_val = cpx(local_real[x], local_imag[x]) * cpx(gate.r11, gate.i11);
-                        local_real[x] = new_val.real();
-                        local_imag[x] = new_val.imag();
-                    }
-                    #endif
-                }
-            }
-        } else {
-            if (controlIsGlobal == 1 && !((blockID>> controlQubit) & 1)) {
-                continue;
-            }
-            if (!targetIsGlobal) {
-                int m = 1 << (LOCAL_QUBIT_SIZE - 1);
-                #ifdef USE_AVX512
-                __m256i mask_inner = _mm256_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << gate.targetQubit));
-                __m256i tar_flag = _mm256_set1_epi32(1 << targetQubit);
-                __m256i idx = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
-                const __m256i inc = _mm256_set1_epi32(8);
-                for (int j = 0; j < m; j += 8) {
-                    __m256i lo = _mm256_add_epi32(idx, _mm256_and_si256(idx, mask_inner));
-                    __m256i hi = _mm256_add_epi32(lo, tar_flag);
-                    __m512d lo_real = _mm512_i32gather_pd(lo, local_real, 8);
-                    __m512d lo_imag = _mm512_i32gather_pd(lo, local_imag, 8);
-                    __m512d hi_real = _mm512_i32gather_pd(hi, local_real, 8);
-                    __m512d hi_imag = _mm512_i32gather_pd(hi, local_imag, 8);
-                    __m512d r00 = _mm512_set1_pd(gate.r00);
-                    __m512d i00 = _mm512_set1_pd(gate.i00);
-                    __m512d r01 = _mm512_set1_pd(gate.r01);
-                    __m512d i01 = _mm512_set1_pd(gate.i01);
-                    __m512d lo_real_new = _mm512_fnmadd_pd(lo_imag, i00, _mm512_mul_pd(lo_real, r00));
-                    lo_real_new = _mm512_fnmadd_pd(hi_imag, i01, _mm512_fmadd_pd(hi_real, r01, lo_real_new));
-                    __m512d lo_imag_new = _mm512_fmadd_pd(lo_imag, r00, _mm512_mul_pd(lo_real, i00));
-                    lo_imag_new = _mm512_fmadd_pd(hi_imag, r01, _mm512_fmadd_pd(hi_real, i01, lo_imag_new));
-                    _mm512_i32scatter_pd(local_real, lo, lo_real_new, 8);
-                    _mm512_i32scatter_pd(local_imag, lo, lo_imag_new, 8);
-                    __m512d r10 = _mm512_set1_pd(gate.r10);
-                    __m512d i10 = _mm512_set1_pd(gate.i10);
-                    __m512d hi_real_new = _mm512_fnmadd_pd(lo_imag, i10, _mm512_mul_pd(lo_real, r10));
-                    __m512d r11 = _mm512_set1_pd(gate.r11);
-                    __m512d i11 = _mm512_set1_pd(gate.i11);
-                    hi_real_new = _mm512_fnmadd_pd(hi_imag, i11, _mm512_fmadd_pd(hi_real, r11, hi_real_new));
-                    __m512d hi_imag_new = _mm512_fmadd_pd(lo_imag, r10, _mm512_mul_pd(lo_real, i10));
-                    hi_imag_new = _mm512_fmadd_pd(hi_imag, r11, _mm512_fmadd_pd(hi_real, i11, hi_imag_new));
-                    _mm512_i32scatter_pd(local_real, hi, hi_real_new, 8);
-                    _mm512_i32scatter_pd(local_imag, hi, hi_imag_new, 8);
-                    idx = _mm256_add_epi32(idx, inc);
-                }
-                #elif defined(USE_AVX2)
-                __m128i mask_inner = _mm_set1_epi32((1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << gate.targetQubit));
-                __m128i tar_flag = _mm_set1_epi32(1 << targetQubit);
-                __m128i idx = _mm_set_epi32(0, 1, 2, 3);
-                const __m128i inc = _mm_set1_epi32(4);
-                for (int j = 0; j < m; j += 4) {
-                    __m128i lo = _mm_add_epi32(idx, _mm_and_si128(idx, mask_inner));
-                    __m128i hi = _mm_add_epi32(lo, tar_flag);
-                    __m256d lo_real = _mm256_i32gather_pd(local_real, lo, 8);
-                    __m256d lo_imag = _mm256_i32gather_pd(local_imag, lo, 8);
-                    __m256d hi_real = _mm256_i32gather_pd(local_real, hi, 8);
-                    __m256d hi_imag = _mm256_i32gather_pd(local_imag, hi, 8);
-                    __m256d r00 = _mm256_set1_pd(gate.r00);
-                    __m256d i00 = _mm256_set1_pd(gate.i00);
-                    __m256d r01 = _mm256_set1_pd(gate.r01);
-                    __m256d i01 = _mm256_set1_pd(gate.i01);
-                    __m256d lo_real_new = _mm256_fnmadd_pd(lo_imag, i00, _mm256_mul_pd(lo_real, r00));
-                    lo_real_new = _mm256_fnmadd_pd(hi_imag, i01, _mm256_fmadd_pd(hi_real, r01, lo_real_new));
-                    __m256d lo_imag_new = _mm256_fmadd_pd(lo_imag, r00, _mm256_mul_pd(lo_real, i00));
-                    lo_imag_new = _mm256_fmadd_pd(hi_imag, r01, _mm256_fmadd_pd(hi_real, i01, lo_imag_new));
-                    _mm256_i32scatter_pd(local_real, lo, lo_real_new, 8);
-                    _mm256_i32scatter_pd(local_imag, lo, lo_imag_new, 8);
-                    __m256d r10 = _mm256_set1_pd(gate.r10);
-                    __m256d i10 = _mm256_set1_pd(gate.i10);
-                    __m256d hi_real_new = _mm256_fnmadd_pd(lo_imag, i10, _mm256_mul_pd(lo_real, r10));
-                    __m256d r11 = _mm256_set1_pd(gate.r11);
-                    __m256d i11 = _mm256_set1_pd(gate.i11);
-                    hi_real_new = _mm256_fnmadd_pd(hi_imag, i11, _mm256_fmadd_pd(hi_real, r11, hi_real_new));
-                    __m256d hi_imag_new = _mm256_fmadd_pd(lo_imag, r10, _mm256_mul_pd(lo_real, i10));
-                    hi_imag_new = _mm256_fmadd_pd(hi_imag, r11, _mm256_fmadd_pd(hi_real, i11, hi_imag_new));
-                    _mm256_i32scatter_pd(local_real, hi, hi_real_new, 8);
-                    _mm256_i32scatter_pd(local_imag, hi, hi_imag_new, 8);
-                    idx = _mm_add_epi32(idx, inc);
-                }
-                #else
-                // TODO: switch (gate)
-                int mask_inner = (1 << (LOCAL_QUBIT_SIZE - 1)) - (1 << gate.targetQubit);
-                #pragma ivdep
-                for (int j = 0; j < m; j++) {
-                    int lo = j + (j & mask_inner);
-                    int hi = lo | (1 << targetQubit);
-                    cpx lo_val = cpx(local_real[lo], local_imag[lo]);
-                    cpx hi_val = cpx(local_real[hi], local_imag[hi]);
-                    cpx lo_val_new = lo_val * cpx(gate.r00, gate.i00) + hi_val * cpx(gate.r01, gate.i01);
-                    local_real[lo] = lo_val_new.real();
-                    local_imag[lo] = lo_val_new.imag();
-                    cpx hi_val_new = lo_val * cpx(gate.r10, gate.i10) + hi_val * cpx(gate.r11, gate.i11);
-                    local_real[hi] = hi_val_new.real();
-                    local_imag[hi] = hi_val_new.imag();
-                }
-                #endif
-            } else {
-                bool isHighBlock = (blockID >> targetQubit) & 1;
-                // TODO: switch (gate)
-                int m = 1 << LOCAL_QUBIT_SIZE;
-                #ifdef USE_AVX512
-                __m512d rr = _mm512_set1_pd(isHighBlock ? gate.r11 : gate.r00);
-                __m512d ii = _mm512_set1_pd(isHighBlock ? gate.i11 : gate.i00);
-                __m256i idx = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
-                const __m256i inc = _mm256_set1_epi32(8);
-                for (int j = 0; j < m; j += 8) {
-                    __m512d x_real = _mm512_i32gather_pd(idx, local_real, 8);
-                    __m512d x_imag = _mm512_i32gather_pd(idx, local_imag, 8);
-                    __m512d x_real_new = _mm512_fnmadd_pd(x_imag, ii, _mm512_mul_pd(x_real, rr));
-                    __m512d x_imag_new = _mm512_fmadd_pd(x_imag, rr, _mm512_mul_pd(x_real, ii));
-                    _mm512_i32scatter_pd(local_real, idx, x_real_new, 8);
-                    _mm512_i32scatter_pd(local_imag, idx, x_imag_new, 8);
-                    idx = _mm256_add_epi32(idx, inc);
-                }
-                #elif defined(USE_AVX2)
-                __m256d rr = _mm256_set1_pd(isHighBlock ? gate.r11 : gate.r00);
-                __m256d ii = _mm256_set1_pd(isHighBlock ? gate.i11 : gate.i00);
-                __m128i idx = _mm_set_epi32(0, 1, 2, 3);
-                const __m128i inc = _mm_set1_epi32(4);
-                for (int j = 0; j < m; j += 4) {
-                    __m256d x_real = _mm256_i32gather_pd(local_real, idx, 8);
-                    __m256d x_imag = _mm256_i32gather_pd(local_imag, idx, 8);
-                    __m256d x_real_new = _mm256_fnmadd_pd(x_imag, ii, _mm256_mul_pd(x_real, rr));
-                    __m256d x_imag_new = _mm256_fmadd_pd(x_imag, rr, _mm256_mul_pd(x_real, ii));
-                    _mm256_i32scatter_pd(local_real, idx, x_real_new, 8);
-                    _mm256_i32scatter_pd(local_imag, idx, x_imag_new, 8);
-                    idx = _mm_add_epi32(idx, inc);
-                }
-                #else
-                cpx param = isHighBlock ? cpx(gate.r11, gate.i11) : cpx(gate.r00, gate.i00);
-                #pragma ivdep
-                for (int j = 0; j < m; j++) {
-                    cpx new_val = cpx(local_real[j], local_imag[j]) * param;
-                    local_real[j] = new_val.real();
-                    local_imag[j] = new_val.imag();
-                }
-                #endif
-            }
+    groups[0].tileQubits = tileQubits;
+    for (int i = 0; i < numGroups; i++) {
+        auto& gates = groups[i].gates;
+        idx_t relatedLogicQb = groups[i].relatedQubits;
+        if (bitCount(relatedLogicQb) < MyGlobalVars::blockQubits) {
+            relatedLogicQb = fillRelatedQubits(relatedLogicQb);
+        }
+        groups[i].phyRelatedQubits = toPhyQubitSet(relatedLogicQb);
+        // block ids only count the qubits of the tile
+        std::map<int, int> toID = getLogicShareMap(groups[i].phyRelatedQubits, numLocalQubits, tileQubits);
+        assert(gates.size() < MAX_GATE);
+        groups[i].kernelGates.clear();
+        for (size_t j = 0; j < gates.size(); j++) {
+            groups[i].kernelGates.push_back(getGate(gates[j], idx_t(MyMPI::rank * MyGlobalVars::localGPUs) << inactive, numLocalQubits, relatedLogicQb, toID));
+            trackPauliFrame(gates[j]);
         }
+        foldGlobalPhase(groups[i]);
+        setState(groups[i].state);
     }
 }
 
-void CpuExecutor::launchPerGateGroup(std::vector<Gate>& gates, KernelGate hostGates[], const State& state, idx_t relatedQubits, int numLocalQubits) {
-    cpx* sv = deviceStateVec[0];
-    #pragma omp parallel for
-    for (int blockID = 0; blockID < (1 << (numLocalQubits - LOCAL_QUBIT_SIZE)); blockID++) {
-        value_t local_real[1 << LOCAL_QUBIT_SIZE];
-        value_t local_imag[1 << LOCAL_QUBIT_SIZE];
-        idx_t blockHot = (idx_t(1) << numLocalQubits) - 1 - relatedQubits;
-        unsigned int bias = 0;
-        {
-            int bid = blockID;
-            for (unsigned int bit = 1; bit < (1u << numLocalQubits); bit <<= 1) {
-                if (blockHot & bit) {
-                    if (bid & 1)
-                        bias |= bit;
-                    bid >>= 1;
-                }
-            }
-        }
-        fetch_data(local_real, local_imag, sv, bias, relatedQubits);
-        apply_gate_group(local_real, local_imag, gates.size(), blockID, hostGates);
-        save_data(sv, local_real, local_imag, bias, relatedQubits);
+void CpuExecutor::applySuperGroup(GateGroup* groups, int numGroups) {
+    if (groups[0].tileQubits == 0) {
+        Executor::applySuperGroup(groups, numGroups);
+        return;
+    }
+    int numLocalQubits = groups[0].activeQubits;
+    std::vector<KernelGate*> gatePtrs;
+    std::vector<int> numGates;
+    std::vector<idx_t> relatedPhyQb;
+    for (int i = 0; i < numGroups; i++) {
+        globalPhase[0] *= groups[i].globalPhase[0];
+        if (groups[i].kernelGates.empty())
+            continue;
+        gatePtrs.push_back(groups[i].kernelGates.data());
+        numGates.push_back(groups[i].kernelGates.size());
+        relatedPhyQb.push_back(groups[i].phyRelatedQubits);
     }
-    // for (int i = 0; i < gates.size(); i++) {
-    //     printf("Gate %d [%d %d %lld] %d %d\n", hostGates[i].type, hostGates[i].encodeQubit, hostGates[i].controlQubit, hostGates[i].targetQubit, hostGates[i].controlIsGlobal, hostGates[i].targetIsGlobal);
-    // }
-    // printf("apply gate group: %f %f %f %f\n", sv[0].real(), sv[0].imag(), sv[1].real(), sv[1].imag());
+    if (gatePtrs.size() > 0)
+        kernels.svTiles(deviceStateVec[0], gatePtrs.size(), gatePtrs.data(), numGates.data(), relatedPhyQb.data(), groups[0].tileQubits, numLocalQubits, MyGlobalVars::blockQubits);
+    setState(groups[numGroups - 1].state);
 }
+#endif
 #elif GPU_BACKEND==2
 void CpuExecutor::launchPerGateGroup(std::vector<Gate>& gates, KernelGate hostGates[], const State& state, idx_t relatedQubits, int numLocalQubits) {
     #pragma omp parallel
@@ -910,6 +294,12 @@ void CpuExecutor::launchPerGateGroup(std::vector<Gate>& gates, KernelGate hostGa
 
 void CpuExecutor::deviceFinalize() {}
 
+#ifdef LAZY_ACTIVATION
+void CpuExecutor::zeroAmps(idx_t begin, idx_t end) {
+    std::fill_n(deviceStateVec[0] + begin, end - begin, cpx(0));
+}
+#endif
+
 void CpuExecutor::allBarrier() {
 #if USE_MPI
     checkMPIErrors(MPI_Barrier(MPI_COMM_WORLD));
@@ -943,6 +333,9 @@ void CpuExecutor::inplaceAll2All(int commSize, std::vector<int> comm, const Stat
     while (sliceSize < MAX_SLICE && !(localMask >> sliceSize & 1))
         sliceSize ++;
 
+#ifdef AOSOA_LAYOUT
+    fromAoSoA(deviceStateVec[0], idx_t(1) << numLocalQubits);
+#endif
     cpx* tmpBuffer[MyGlobalVars::localGPUs];
     size_t tmpStart = 1ll << numLocalQubits;
     for (int i = 0; i < MyGlobalVars::localGPUs; i++)
@@ -980,6 +373,9 @@ void CpuExecutor::inplaceAll2All(int commSize, std::vector<int> comm, const Stat
             }
         }
     }
+#ifdef AOSOA_LAYOUT
+    toAoSoA(deviceStateVec[0], idx_t(1) << numLocalQubits);
+#endif
 }
 
 void CpuExecutor::dm_transpose()  {
@@ -1011,8 +407,17 @@ void CpuExecutor::dm_transpose()  {
     memcpy(deviceStateVec[0], deviceBuffer[0], (sizeof(cpx) << numQubits) / MyGlobalVars::numGPUs);
 }
 void CpuExecutor::launchPerGateGroupSliced(std::vector<Gate>& gates, KernelGate hostGates[], idx_t relatedQubits, int numLocalQubits, int sliceID) { UNIMPLEMENTED(); }
-void CpuExecutor::launchBlasGroup(GateGroup& gg, int numLocalQubits) { UNIMPLEMENTED(); }
+
+void CpuExecutor::launchBlasGroup(GateGroup& gg, int numLocalQubits) {
+    idx_t numElements = idx_t(1) << numLocalQubits;
+    int K = 1 << gg.matQubit;
+    this->transpose(gg.transPlans);
+    kernels.gemm(K, numElements / K, gg.deviceMats[0], deviceBuffer[0], deviceStateVec[0]);
+}
+
+// overlapping is not supported on cpu (see all2all)
 void CpuExecutor::launchBlasGroupSliced(GateGroup& gg, int numLocalQubits, int sliceID) { UNIMPLEMENTED(); }
+
 void CpuExecutor::sliceBarrier(int sliceID) { UNIMPLEMENTED(); }
 void CpuExecutor::eventBarrier() { UNIMPLEMENTED(); }
 void CpuExecutor::eventBarrierAll() {
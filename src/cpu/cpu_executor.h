@@ -3,6 +3,20 @@
 #include "hptt.h"
 
 namespace CpuImpl {
+// lowering of the group kernels: block bias tables and L2 super-groups
+class CpuLowering: public Lowering {
+public:
+    CpuLowering(int numQubits, Schedule& schedule);
+
+protected:
+#ifdef CPU_BIAS_TABLE
+    void lowerPerGateGroup(GateGroup& gg);
+#endif
+#ifdef CPU_L2_QUBITS
+    void lowerSuperGroup(GateGroup* groups, int numGroups);
+#endif
+};
+
 class CpuExecutor: public Executor {
 public:
     CpuExecutor(std::vector<cpx*> deviceStateVec, int numQubits, Schedule& schedule);
@@ -16,10 +30,19 @@ protected:
     void launchPerGateGroupSliced(std::vector<Gate>& gates, KernelGate hostGates[], idx_t relatedQubits, int numLocalQubits, int sliceID);
     void launchBlasGroup(GateGroup& gg, int numLocalQubits);
     void launchBlasGroupSliced(GateGroup& gg, int numLocalQubits, int sliceID);
+#ifdef CPU_BIAS_TABLE
+    void applyPerGateGroup(GateGroup& gg);
+#endif
+#ifdef CPU_L2_QUBITS
+    void applySuperGroup(GateGroup* groups, int numGroups);
+#endif
     void deviceFinalize();
     void sliceBarrier(int sliceID);
     void eventBarrier();
     void eventBarrierAll();
     void allBarrier();
+#ifdef LAZY_ACTIVATION
+    void zeroAmps(idx_t begin, idx_t end);
+#endif
 };
 }
\ No newline at end of file
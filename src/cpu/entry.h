@@ -9,5 +9,9 @@ void initCpu();
 void initState(std::vector<cpx*> &deviceStateVec, int numQubits);
 void initHpttPlans(std::vector<std::shared_ptr<hptt::Transpose<cpx>>*>& transPlanPointers, const std::vector<int*>& transPermPointers, const std::vector<int>& locals, int numLocalQubits);
 void copyBackState(std::vector<cpx>& result, const std::vector<cpx*>& deviceStateVec, int numQubits);
+cpx getAmp(const std::vector<cpx*>& deviceStateVec, int gpuID, idx_t localIdx);
+#ifdef CPU_AUTOTUNE
+int autotuneBlockQubits(int numLocalQubits);
+#endif
 void destroyState(std::vector<cpx*>& deviceStateVec);
 }
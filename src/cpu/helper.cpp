@@ -1,7 +1,13 @@
 #include "cpu/entry.h"
 #include "cpu/header.h"
+#include "cpu/kernel.h"
+#include "logger.h"
+#include "schedule_cache.h"
 #include <cstring>
+#include <cmath>
+#include <chrono>
 #include <memory>
+#include <unistd.h>
 #include "hptt.h"
 
 namespace MyGlobalVars {
@@ -10,17 +16,42 @@ namespace MyGlobalVars {
 
 namespace CpuImpl {
 
+KernelTable kernels;
+idx_t llcBytes;
+
+#ifdef CPU_BIAS_TABLE
+#define KERNEL_TABLE(NAME, ISA) KernelTable{NAME, ISA::svGroup, ISA::svTiles, ISA::dmGroup, ISA::gemm, ISA::svGroupTable}
+#else
+#define KERNEL_TABLE(NAME, ISA) KernelTable{NAME, ISA::svGroup, ISA::svTiles, ISA::dmGroup, ISA::gemm}
+#endif
+
 void initCpu() {
     #pragma omp parallel
     {
         #pragma omp master
         MyGlobalVars::n_thread = omp_get_num_threads();
     }
+    __builtin_cpu_init();
+    kernels = KERNEL_TABLE("scalar", Scalar);
+#ifdef WITH_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi2"))
+        kernels = KERNEL_TABLE("avx2", Avx2);
+#endif
+#ifdef WITH_AVX512_KERNEL
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("bmi2"))
+        kernels = KERNEL_TABLE("avx512", Avx512);
+#endif
+    Logger::add("CPU kernels: %s", kernels.name);
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (llc <= 0)
+        llc = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    llcBytes = llc > 0 ? llc : 0;
+    Logger::add("CPU LLC: %lld KB", (long long) llcBytes >> 10);
 }
 
 void initState(std::vector<cpx*> &deviceStateVec, int numQubits) {
     size_t size = (sizeof(cpx) << numQubits) >> MyGlobalVars::bit;
-    if ((MyGlobalVars::numGPUs > 1 && !INPLACE) || GPU_BACKEND == 3 || GPU_BACKEND == 4) {
+    if ((MyGlobalVars::numGPUs > 1 && !INPLACE) || GPU_BACKEND == 3 || GPU_BACKEND == 4 || GPU_BACKEND == 5) {
         size <<= 1;
     }
 #if INPLACE
@@ -28,8 +59,16 @@ void initState(std::vector<cpx*> &deviceStateVec, int numQubits) {
 #endif
     deviceStateVec.resize(MyGlobalVars::localGPUs);
     for (int g = 0; g < MyGlobalVars::localGPUs; g++) {
-        deviceStateVec[g] = (cpx*) malloc(size);
+        // cache line aligned, so that the AoSoA blocks and the vector loads of the kernels do not straddle lines
+        if (posix_memalign((void**) &deviceStateVec[g], 64, size) != 0) {
+            UNREACHABLE();
+        }
+#ifdef LAZY_ACTIVATION
+        // the executor zeroes the rest when the first group that needs it runs
+        std::fill_n(deviceStateVec[g], std::min(size / sizeof(cpx), size_t(1) << MyGlobalVars::blockQubits), cpx(0));
+#else
         memset(deviceStateVec[g], 0, size);
+#endif
     }
     cpx one(1.0);
     if  (!USE_MPI || MyMPI::rank == 0) {
@@ -62,8 +101,137 @@ void copyBackState(std::vector<cpx>& result, const std::vector<cpx*>& deviceStat
     for (int g = 0; g < MyGlobalVars::localGPUs; g++) {
         memcpy(result.data() + elements * g, deviceStateVec[g], sizeof(cpx) << (numQubits - MyGlobalVars::bit));
     }
+#ifdef AOSOA_LAYOUT
+    fromAoSoA(result.data(), result.size());
+#endif
+}
+
+cpx getAmp(const std::vector<cpx*>& deviceStateVec, int gpuID, idx_t localIdx) {
+#ifdef AOSOA_LAYOUT
+    const value_t* blk = aosoa_block(deviceStateVec[gpuID], localIdx);
+    int i = localIdx % AOSOA_WIDTH;
+    return cpx(blk[i], blk[AOSOA_WIDTH + i]);
+#else
+    return deviceStateVec[gpuID][localIdx];
+#endif
+}
+
+#ifdef AOSOA_LAYOUT
+void toAoSoA(cpx* sv, idx_t numElements) {
+    #pragma omp parallel for
+    for (idx_t b = 0; b < numElements; b += AOSOA_WIDTH) {
+        value_t* blk = aosoa_block(sv, b);
+        value_t tmp[AOSOA_WIDTH * 2];
+        for (int i = 0; i < AOSOA_WIDTH; i++) {
+            tmp[i] = blk[i * 2];
+            tmp[AOSOA_WIDTH + i] = blk[i * 2 + 1];
+        }
+        memcpy(blk, tmp, sizeof(tmp));
+    }
 }
 
+void fromAoSoA(cpx* sv, idx_t numElements) {
+    #pragma omp parallel for
+    for (idx_t b = 0; b < numElements; b += AOSOA_WIDTH) {
+        value_t* blk = aosoa_block(sv, b);
+        value_t tmp[AOSOA_WIDTH * 2];
+        for (int i = 0; i < AOSOA_WIDTH; i++) {
+            tmp[i * 2] = blk[i];
+            tmp[i * 2 + 1] = blk[AOSOA_WIDTH + i];
+        }
+        memcpy(blk, tmp, sizeof(tmp));
+    }
+}
+#endif
+
+#ifdef CPU_AUTOTUNE
+// probe group of the autotuner: an H, a CNOT and an RZ on every qubit of the block
+static std::vector<KernelGate> probeGates(int blockQubits) {
+    value_t s = 1.0 / sqrt(2.0);
+    cpx h[2][2] = {{s, s}, {s, -s}};
+    cpx x[2][2] = {{0, 1}, {1, 0}};
+    cpx rz[2][2] = {{cpx(cos(0.3), -sin(0.3)), 0}, {0, cpx(cos(0.3), sin(0.3))}};
+    std::vector<KernelGate> gates;
+    for (int q = 0; q < blockQubits; q++) {
+        gates.push_back(KernelGate::singleQubitGate(GateType::H, q, 0, h));
+        gates.push_back(KernelGate::controlledGate(GateType::CNOT, q, 0, (q + 1) % blockQubits, 0, x));
+        gates.push_back(KernelGate::singleQubitGate(GateType::RZ, q, 0, rz));
+    }
+    return gates;
+}
+
+// Times the probe group on a 2^AUTOTUNE_QUBITS state for every instantiated
+// block size (best of AUTOTUNE_REPEAT runs) and returns the one with the lowest
+// cost per gate. The related qubits of the probe are half low, half high
+// qubits, like a typical group. Rank 0 measures and broadcasts, so that all
+// ranks run the same schedule. The choice is made once per process and kept in
+// the schedule cache, so that later runs hit the same cache entries.
+const int AUTOTUNE_REPEAT = 5;
+
+static int measureBlockQubits(int probeQubits) {
+    cpx* sv;
+    if (posix_memalign((void**) &sv, 64, sizeof(cpx) << probeQubits) != 0) {
+        UNREACHABLE();
+    }
+    std::fill_n(sv, idx_t(1) << probeQubits, cpx(0));
+    int best = MyGlobalVars::blockQubits;
+    double bestCost = 1e100;
+    for (int b = MIN_BLOCK_QUBITS; b <= std::min(MAX_BLOCK_QUBITS, probeQubits); b++) {
+        std::vector<KernelGate> gates = probeGates(b);
+        int low = std::max(COALESCE_GLOBAL, b / 2);
+        idx_t related = ((idx_t(1) << low) - 1) | (((idx_t(1) << (b - low)) - 1) << (probeQubits - (b - low)));
+        kernels.svGroup(sv, gates.data(), gates.size(), related, probeQubits, b); // warm up
+        double cost = 1e100;
+        for (int r = 0; r < AUTOTUNE_REPEAT; r++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            kernels.svGroup(sv, gates.data(), gates.size(), related, probeQubits, b);
+            auto end = std::chrono::high_resolution_clock::now();
+            cost = std::min(cost, std::chrono::duration<double>(end - start).count() / gates.size());
+        }
+        if (cost < bestCost) {
+            bestCost = cost;
+            best = b;
+        }
+    }
+    free(sv);
+    return best;
+}
+
+int autotuneBlockQubits(int numLocalQubits) {
+    static int tunedProbe = -1, tuned;
+    int probeQubits = std::min(numLocalQubits, AUTOTUNE_QUBITS);
+    if (probeQubits == tunedProbe) {
+        Logger::add("Block qubits: %d (autotuned before)", tuned);
+        return tuned;
+    }
+    auto start = std::chrono::system_clock::now();
+    int best = MyGlobalVars::blockQubits, cached = 0;
+    if (!USE_MPI || MyMPI::rank == 0) {
+        char name[64];
+        sprintf(name, "block-qubits-%s-t%d-q%d", kernels.name, MyGlobalVars::n_thread, probeQubits);
+        cached = ScheduleCache::loadTuning(name, best) && best >= MIN_BLOCK_QUBITS && best <= MAX_BLOCK_QUBITS;
+        if (!cached) {
+            best = measureBlockQubits(probeQubits);
+            ScheduleCache::storeTuning(name, best);
+        }
+    }
+#if USE_MPI
+    int msg[2] = {best, cached};
+    checkMPIErrors(MPI_Bcast(msg, 2, MPI_INT, 0, MPI_COMM_WORLD));
+    best = msg[0]; cached = msg[1];
+#endif
+    auto end = std::chrono::system_clock::now();
+    if (cached) {
+        Logger::add("Block qubits: %d (autotuned, cached)", best);
+    } else {
+        Logger::add("Block qubits: %d (autotuned in %d us)", best, int(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+    }
+    tunedProbe = probeQubits;
+    tuned = best;
+    return best;
+}
+#endif
+
 void destroyState(std::vector<cpx*>& deviceStateVec) {
     for (int g = 0; g < MyGlobalVars::localGPUs; g++) {
         free(deviceStateVec[g]);
@@ -0,0 +1,164 @@
+#pragma once
+#include "utils.h"
+#include "gate.h"
+#include <algorithm>
+#include <vector>
+#include <x86intrin.h>
+
+// The group / blas kernels are compiled once per instruction set
+// (kernel_scalar.cpp, kernel_avx2.cpp, kernel_avx512.cpp) and the best
+// variant supported by the running CPU is picked in CpuImpl::initCpu().
+namespace CpuImpl {
+
+// Precision of the local buffers (local_real / local_imag) of the group
+// kernels. A MIXED_PRECISION build stores the state vector as complex<float>
+// and widens each block to double in fetch_data / narrows it in save_data.
+#ifdef MIXED_PRECISION
+typedef double local_t;
+#else
+typedef value_t local_t;
+#endif
+typedef std::complex<local_t> local_cpx;
+#if defined(USE_DOUBLE) || defined(MIXED_PRECISION)
+#define LOCAL_DOUBLE
+#endif
+
+// An AOSOA_LAYOUT build keeps the state vector in blocks of AOSOA_WIDTH
+// amplitudes, stored as one cache line of AOSOA_WIDTH reals followed by one of
+// AOSOA_WIDTH imags (at least the SIMD width of every kernel variant). A
+// block occupies the same bytes as AOSOA_WIDTH interleaved cpx, so the state
+// is still addressed as cpx* and aligned ranges can be moved (MPI, memcpy)
+// without conversion. Amplitude i lives at aosoa_block(sv, i)[i % AOSOA_WIDTH]
+// (real) and [AOSOA_WIDTH + i % AOSOA_WIDTH] (imag).
+#ifdef AOSOA_LAYOUT
+const int AOSOA_WIDTH = 64 / sizeof(value_t);
+
+inline value_t* aosoa_block(cpx* sv, idx_t i) {
+    return reinterpret_cast<value_t*>(sv + (i & ~idx_t(AOSOA_WIDTH - 1)));
+}
+
+inline const value_t* aosoa_block(const cpx* sv, idx_t i) {
+    return reinterpret_cast<const value_t*>(sv + (i & ~idx_t(AOSOA_WIDTH - 1)));
+}
+
+// in-place conversion of numElements amplitudes between interleaved and blocked layout
+void toAoSoA(cpx* sv, idx_t numElements);
+void fromAoSoA(cpx* sv, idx_t numElements);
+#endif
+
+// The state-vector group kernels are instantiated for every block size
+// (qubits per cache block) in [MIN_BLOCK_QUBITS, MAX_BLOCK_QUBITS] and the one
+// in MyGlobalVars::blockQubits is dispatched at runtime. The density-matrix
+// kernels only use LOCAL_QUBIT_SIZE.
+#if MODE == 0 && GPU_BACKEND == 1
+const int MIN_BLOCK_QUBITS = std::min(CPU_MIN_BLOCK_DEFINED, LOCAL_QUBIT_SIZE);
+const int MAX_BLOCK_QUBITS = std::max(CPU_MAX_BLOCK_DEFINED, LOCAL_QUBIT_SIZE);
+#else
+const int MIN_BLOCK_QUBITS = LOCAL_QUBIT_SIZE;
+const int MAX_BLOCK_QUBITS = LOCAL_QUBIT_SIZE;
+#endif
+
+// deposit the low bits of id at the set bits of mask (block id -> bias), the
+// portable version of block_bias in simd.h
+inline unsigned int spread_bits(unsigned int id, idx_t mask) {
+    unsigned int ret = 0;
+    for (unsigned int bit = 1; bit <= mask; bit <<= 1) {
+        if (mask & bit) {
+            if (id & 1)
+                ret |= bit;
+            id >>= 1;
+        }
+    }
+    return ret;
+}
+
+#ifdef CPU_BIAS_TABLE
+// bias of every block of a group over the local qubits outside relatedQubits,
+// built once per schedule by CpuLowering::lowerPerGateGroup
+inline void block_bias_table(std::vector<unsigned int>& table, idx_t relatedQubits, int numLocalQubits, int blockQubits) {
+    idx_t blockHot = (idx_t(1) << numLocalQubits) - 1 - relatedQubits;
+    table.resize(idx_t(1) << (numLocalQubits - blockQubits));
+    for (size_t i = 0; i < table.size(); i++)
+        table[i] = spread_bits(i, blockHot);
+}
+#endif
+
+// Size of the last level cache in bytes (0 if unknown), set by initCpu(). A
+// CPU_STREAM_STORES build writes blocks back with non-temporal stores when the
+// state is more than STREAM_FACTOR times larger, as it would be evicted before
+// the next group reads it anyway. The lines were just read by fetch_data, so
+// this only pays off where the write-back, not the read, is the bottleneck.
+extern idx_t llcBytes;
+const int STREAM_FACTOR = 4;
+
+inline bool use_stream_stores(idx_t stateBytes) {
+#ifdef CPU_STREAM_STORES
+    return llcBytes > 0 && stateBytes > STREAM_FACTOR * llcBytes;
+#else
+    return false;
+#endif
+}
+
+inline void prefetch_l2(const void* p, size_t bytes) {
+    for (size_t off = 0; off < bytes; off += 64)
+        _mm_prefetch((const char*) p + off, _MM_HINT_T1);
+}
+
+// amplitudes per 16-byte non-temporal store; the kernels write shorter runs
+// (COALESCE_GLOBAL = 0 with float) with plain stores
+const int STREAM_MIN_CPX = 16 / sizeof(cpx);
+
+// non-temporal store of n interleaved amplitudes (n a multiple of STREAM_MIN_CPX, dst 16-byte aligned)
+inline void stream_cpx(cpx* dst, const local_t* re, const local_t* im, int n) {
+#ifdef USE_DOUBLE
+    for (int i = 0; i < n; i++)
+        _mm_stream_pd((double*) (dst + i), _mm_setr_pd(re[i], im[i]));
+#else
+    for (int i = 0; i < n; i += 2)
+        _mm_stream_ps((float*) (dst + i), _mm_setr_ps(re[i], im[i], re[i + 1], im[i + 1]));
+#endif
+}
+
+// non-temporal store of n scalars (n a multiple of 4, dst 16-byte aligned)
+inline void stream_scalar(value_t* dst, const local_t* src, int n) {
+#ifdef USE_DOUBLE
+    for (int i = 0; i < n; i += 2)
+        _mm_stream_pd(dst + i, _mm_setr_pd(src[i], src[i + 1]));
+#else
+    for (int i = 0; i < n; i += 4)
+        _mm_stream_ps(dst + i, _mm_setr_ps(src[i], src[i + 1], src[i + 2], src[i + 3]));
+#endif
+}
+
+struct KernelTable {
+    const char* name;
+    void (*svGroup)(cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, int numLocalQubits, int blockQubits);
+    void (*svTiles)(cpx* sv, int numGroups, KernelGate* hostGates[], const int numGates[], const idx_t relatedQubits[], idx_t tileQubits, int numLocalQubits, int blockQubits);
+    void (*dmGroup)(cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, int numLocalQubits);
+    void (*gemm)(int K, idx_t numCols, const cpx* a, const cpx* b, cpx* c);
+#ifdef CPU_BIAS_TABLE
+    // svGroup with the bias of block i read from blockBias[i]
+    void (*svGroupTable)(cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, const unsigned int* blockBias, int numLocalQubits, int blockQubits);
+#endif
+};
+
+extern KernelTable kernels;
+
+#define DECLARE_KERNELS(ISA) \
+namespace ISA { \
+    void svGroup(cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, int numLocalQubits, int blockQubits); \
+    void svTiles(cpx* sv, int numGroups, KernelGate* hostGates[], const int numGates[], const idx_t relatedQubits[], idx_t tileQubits, int numLocalQubits, int blockQubits); \
+    void dmGroup(cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, int numLocalQubits); \
+    void gemm(int K, idx_t numCols, const cpx* a, const cpx* b, cpx* c); \
+    void svGroupTable(cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, const unsigned int* blockBias, int numLocalQubits, int blockQubits); \
+}
+
+DECLARE_KERNELS(Scalar)
+#ifdef WITH_AVX2_KERNEL
+DECLARE_KERNELS(Avx2)
+#endif
+#ifdef WITH_AVX512_KERNEL
+DECLARE_KERNELS(Avx512)
+#endif
+
+}
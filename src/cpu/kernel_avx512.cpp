@@ -0,0 +1,14 @@
+#ifdef WITH_AVX512_KERNEL
+// Everything shared with the other variants is included before the target
+// pragma, so only the functions in CpuImpl::Avx512 are built with AVX-512.
+#include "cpu/kernel.h"
+#include <cstring>
+#include <assert.h>
+#include <x86intrin.h>
+
+#pragma GCC target("avx512f,avx2,fma,bmi2")
+#define KERNEL_ISA Avx512
+#define USE_AVX512
+#include "cpu/kernel_sv.h"
+#include "cpu/kernel_dm.h"
+#endif
@@ -0,0 +1,600 @@
+// Density-matrix group kernels, compiled once per instruction set like
+// kernel_sv.h. The vector path needs scatter stores, so only the AVX-512
+// variant (8 double or 16 float lanes) has one; the others run the scalar loops.
+#include "cpu/kernel.h"
+#include <cstring>
+#include <assert.h>
+#include <x86intrin.h>
+#include "cpu/simd.h"
+
+namespace CpuImpl {
+namespace KERNEL_ISA {
+
+inline void fetch_data_dm(local_t* local_real, local_t* local_imag, const cpx* deviceStateVec, int bias, idx_t related2) {
+    int x;
+    unsigned int y;
+    idx_t mask = (1 << (COALESCE_GLOBAL * 2)) - 1;
+    assert((related2 & mask) == mask);
+    related2 -= mask;
+    for (x = (1 << (LOCAL_QUBIT_SIZE * 2)) - 1 - mask, y = related2; x >= 0; x -= (1 << (COALESCE_GLOBAL * 2)), y = related2 & (y-1)) {
+        #pragma ivdep
+        for (int i = 0; i < (1 << (COALESCE_GLOBAL * 2)); i++) {
+            local_real[x + i] = deviceStateVec[(bias | y) + i].real();
+            local_imag[x + i] = deviceStateVec[(bias | y) + i].imag();
+            // printf("fetch %d <- %d\n", x + i, (bias | y) + i);
+        }
+    }
+}
+
+inline void save_data_dm(cpx* deviceStateVec, const local_t* local_real, const local_t* local_imag, int bias, idx_t related2, bool stream) {
+    int x;
+    unsigned int y;
+    idx_t mask = (1 << (COALESCE_GLOBAL * 2)) - 1;
+    stream = stream && (1 << (COALESCE_GLOBAL * 2)) >= STREAM_MIN_CPX;
+    assert((related2 & mask) == mask);
+    related2 -= mask;
+    for (x = (1 << (LOCAL_QUBIT_SIZE * 2)) - 1 - mask, y = related2; x >= 0; x -= (1 << COALESCE_GLOBAL * 2), y = related2 & (y-1)) {
+        if (stream) {
+            stream_cpx(deviceStateVec + (bias | y), local_real + x, local_imag + x, 1 << (COALESCE_GLOBAL * 2));
+            continue;
+        }
+        #pragma ivdep
+        for (int i = 0; i < (1 << (COALESCE_GLOBAL * 2)); i++) {
+            deviceStateVec[(bias | y) + i].real(local_real[x + i]);
+            deviceStateVec[(bias | y) + i].imag(local_imag[x + i]);
+        }
+    }
+    if (stream)
+        _mm_sfence();
+}
+
+inline void prefetch_data_dm(const cpx* deviceStateVec, int bias, idx_t related2) {
+    idx_t mask = (1 << (COALESCE_GLOBAL * 2)) - 1;
+    related2 -= mask;
+    unsigned int y = related2;
+    for (int x = (1 << (LOCAL_QUBIT_SIZE * 2)) - 1 - mask; x >= 0; x -= (1 << COALESCE_GLOBAL * 2), y = related2 & (y-1))
+        prefetch_l2(deviceStateVec + (bias | y), sizeof(cpx) << (COALESCE_GLOBAL * 2));
+}
+
+#define CPXL(idx) (local_cpx(local_real[idx], local_imag[idx]))
+#define CPXS(idx, val) {local_real[idx] = val.real(); local_imag[idx] = val.imag(); }
+#define GATHER(tr, ti, idx) vreg tr = vgather(idx, local_real); vreg ti = vgather(idx, local_imag);
+#define SCATTER(tr, ti, idx) vscatter(local_real, idx, tr); vscatter(local_imag, idx, ti);
+#define NEW_ZERO_REG(reg) vreg reg = vset1(0.0);
+#define LD_REG(tr, ti, val) vreg tr = vset1((val).real()); vreg ti = vset1((val).imag());
+
+// t = a*b + c*d
+// tr = ar * br - ai * bi + cr * dr - ci * di
+// ti = ar * bi + ai * br + cr * di + ci * dr
+#define CALC_AB_ADD_CD(tr, ti, ar, ai, br, bi, cr, ci, dr, di) \
+    vreg tr = vfnmadd(ci, di, vfmadd(cr, dr, vfnmadd(ai, bi, vmul(ar, br)))); \
+    vreg ti = vfmadd(ci, dr, vfmadd(cr, di, vfmadd(ai, br, vmul(ar, bi))));
+
+// s = s + a*conj(b) + c*conj(d)
+// sr = sr + ar * br + ai * bi + cr * dr + ci * di
+// si = si - ar * bi + ai * br - cr * di + ci * dr
+#define CALC_ADD_AB_ADD_CD_NT(sr, si, ar, ai, br, bi, cr, ci, dr, di) \
+    sr = vfmadd(ci, di, vfmadd(cr, dr, vfmadd(ai, bi, vfmadd(ar, br, sr)))); \
+    si = vfmadd(ci, dr, vfnmadd(cr, di, vfmadd(ai, br, vfnmadd(ar, bi, si))));
+
+#ifdef USE_AVX512
+
+void dbgv(const char* name, vidx reg) {
+    int val[VLEN];
+    memcpy(val, &reg, sizeof(reg));
+    printf("%s:", name);
+    for (int k = 0; k < VLEN; k++) printf(" %d", val[k]);
+    printf("\n");
+}
+void dbgv(const char* name, vreg reg) {
+    local_t val[VLEN];
+    memcpy(val, &reg, sizeof(reg));
+    printf("%s:", name);
+    for (int k = 0; k < VLEN; k++) printf(" %f", val[k]);
+    printf("\n");
+}
+#endif
+
+inline void apply_gate_group_dm(local_t* local_real, local_t* local_imag, int numGates, int blockID, KernelGate hostGates[]) {
+#if MODE == 2
+    constexpr int local2 = LOCAL_QUBIT_SIZE * 2;
+    for (int i = 0; i < numGates; i++) {
+        auto& gate = hostGates[i];
+        int controlQubit = gate.controlQubit;
+        int targetQubit = gate.targetQubit;
+
+        if (gate.controlQubit == -1) { // single qubit gate
+            // skip due to error fusion
+        } else {
+            if (gate.controlQubit == -3) { // two qubit gate
+                controlQubit = gate.encodeQubit;
+                controlQubit *= 2;
+                targetQubit *= 2;
+                int m = 1 << (local2 - 2);
+                int low_bit = std::min(controlQubit, targetQubit);
+                int high_bit = std::max(controlQubit, targetQubit);
+#ifdef USE_AVX512
+                vidx mask_inner = vidx_set1((1 << (local2 - 2)) - (1 << low_bit));
+                vidx mask_outer = vidx_set1((1 << (local2 - 1)) - (1 << high_bit));
+                vidx ctr_flag = vidx_set1(1 << controlQubit);
+                vidx tar_flag = vidx_set1(1 << targetQubit);
+                vidx idx = vidx_iota();
+                const vidx inc = vidx_set1(VLEN);
+                for (int j = 0; j < m; j += VLEN) {
+                    vidx lo = vidx_add(idx, vidx_and(idx, mask_inner));
+                    lo = vidx_add(lo, vidx_and(lo, mask_outer));
+                    vidx s00 = lo;
+                    vidx s01 = vidx_add(s00, ctr_flag);
+                    vidx s10 = vidx_add(s00, tar_flag);
+                    vidx s11 = vidx_or(s01, s10);
+
+                    vreg v00_real = vgather(s00, local_real);
+                    vreg v00_imag = vgather(s00, local_imag);
+                    vreg v11_real = vgather(s11, local_real);
+                    vreg v11_imag = vgather(s11, local_imag);
+                    vreg r00 = vset1(gate.r00);
+                    vreg i00 = vset1(gate.i00);
+                    vreg r11 = vset1(gate.r11);
+                    vreg i11 = vset1(gate.i11);
+                    vreg v00_real_new = vfnmadd(v00_imag, i00, vmul(v00_real, r00));
+                    v00_real_new = vfnmadd(v11_imag, i11, vfmadd(v11_real, r11, v00_real_new));
+                    vreg v00_imag_new = vfmadd(v00_imag, r00, vmul(v00_real, i00));
+                    v00_imag_new = vfmadd(v11_imag, r11, vfmadd(v11_real, i11, v00_imag_new));
+                    vscatter(local_real, s00, v00_real_new);
+                    vscatter(local_imag, s00, v00_imag_new);
+                    vreg v11_real_new = vfnmadd(v11_imag, i00, vmul(v11_real, r00));
+                    v11_real_new = vfnmadd(v00_imag, i11, vfmadd(v00_real, r11, v11_real_new));
+                    vreg v11_imag_new = vfmadd(v11_imag, r00, vmul(v11_real, i00));
+                    v11_imag_new = vfmadd(v00_imag, r11, vfmadd(v00_real, i11, v11_imag_new));
+                    vscatter(local_real, s11, v11_real_new);
+                    vscatter(local_imag, s11, v11_imag_new);
+
+                    vreg v01_real = vgather(s01, local_real);
+                    vreg v01_imag = vgather(s01, local_imag);
+                    vreg v10_real = vgather(s10, local_real);
+                    vreg v10_imag = vgather(s10, local_imag);
+                    vreg r01 = vset1(gate.r01);
+                    vreg i01 = vset1(gate.i01);
+                    vreg r10 = vset1(gate.r10);
+                    vreg i10 = vset1(gate.i10);
+                    vreg v01_real_new = vfnmadd(v01_imag, i01, vmul(v01_real, r01));
+                    v01_real_new = vfnmadd(v10_imag, i10, vfmadd(v10_real, r10, v01_real_new));
+                    vreg v01_imag_new = vfmadd(v01_imag, r01, vmul(v01_real, i01));
+                    v01_imag_new = vfmadd(v10_imag, r10, vfmadd(v10_real, i10, v01_imag_new));
+                    vscatter(local_real, s01, v01_real_new);
+                    vscatter(local_imag, s01, v01_imag_new);
+                    vreg v10_real_new = vfnmadd(v10_imag, i01, vmul(v10_real, r01));
+                    v10_real_new = vfnmadd(v01_imag, i10, vfmadd(v01_real, r10, v10_real_new));
+                    vreg v10_imag_new = vfmadd(v10_imag, r01, vmul(v10_real, i01));
+                    v10_imag_new = vfmadd(v01_imag, r10, vfmadd(v01_real, i10, v10_imag_new));
+                    vscatter(local_real, s10, v10_real_new);
+                    vscatter(local_imag, s10, v10_imag_new);
+
+                    idx = vidx_add(idx, inc);
+                }
+                low_bit++; high_bit++;
+                mask_inner = vidx_set1((1 << (local2 - 2)) - (1 << low_bit));
+                mask_outer = vidx_set1((1 << (local2 - 1)) - (1 << high_bit));
+                ctr_flag = vidx_set1(1 << (controlQubit + 1));
+                tar_flag = vidx_set1(1 << (targetQubit + 1));
+                idx = vidx_iota();
+                for (int j = 0; j < m; j += VLEN) {
+                    vidx lo = vidx_add(idx, vidx_and(idx, mask_inner));
+                    lo = vidx_add(lo, vidx_and(lo, mask_outer));
+                    vidx s00 = lo;
+                    vidx s01 = vidx_add(s00, ctr_flag);
+                    vidx s10 = vidx_add(s00, tar_flag);
+                    vidx s11 = vidx_or(s01, s10);
+
+                    vreg v00_real = vgather(s00, local_real);
+                    vreg v00_imag = vgather(s00, local_imag);
+                    vreg v11_real = vgather(s11, local_real);
+                    vreg v11_imag = vgather(s11, local_imag);
+                    vreg r00 = vset1(gate.r00);
+                    vreg i00 = vset1(-gate.i00);
+                    vreg r11 = vset1(gate.r11);
+                    vreg i11 = vset1(-gate.i11);
+                    vreg v00_real_new = vfnmadd(v00_imag, i00, vmul(v00_real, r00));
+                    v00_real_new = vfnmadd(v11_imag, i11, vfmadd(v11_real, r11, v00_real_new));
+                    vreg v00_imag_new = vfmadd(v00_imag, r00, vmul(v00_real, i00));
+                    v00_imag_new = vfmadd(v11_imag, r11, vfmadd(v11_real, i11, v00_imag_new));
+                    vscatter(local_real, s00, v00_real_new);
+                    vscatter(local_imag, s00, v00_imag_new);
+                    vreg v11_real_new = vfnmadd(v11_imag, i00, vmul(v11_real, r00));
+                    v11_real_new = vfnmadd(v00_imag, i11, vfmadd(v00_real, r11, v11_real_new));
+                    vreg v11_imag_new = vfmadd(v11_imag, r00, vmul(v11_real, i00));
+                    v11_imag_new = vfmadd(v00_imag, r11, vfmadd(v00_real, i11, v11_imag_new));
+                    vscatter(local_real, s11, v11_real_new);
+                    vscatter(local_imag, s11, v11_imag_new);
+
+                    vreg v01_real = vgather(s01, local_real);
+                    vreg v01_imag = vgather(s01, local_imag);
+                    vreg v10_real = vgather(s10, local_real);
+                    vreg v10_imag = vgather(s10, local_imag);
+                    vreg r01 = vset1(gate.r01);
+                    vreg i01 = vset1(-gate.i01);
+                    vreg r10 = vset1(gate.r10);
+                    vreg i10 = vset1(-gate.i10);
+                    vreg v01_real_new = vfnmadd(v01_imag, i01, vmul(v01_real, r01));
+                    v01_real_new = vfnmadd(v10_imag, i10, vfmadd(v10_real, r10, v01_real_new));
+                    vreg v01_imag_new = vfmadd(v01_imag, r01, vmul(v01_real, i01));
+                    v01_imag_new = vfmadd(v10_imag, r10, vfmadd(v10_real, i10, v01_imag_new));
+                    vscatter(local_real, s01, v01_real_new);
+                    vscatter(local_imag, s01, v01_imag_new);
+                    vreg v10_real_new = vfnmadd(v10_imag, i01, vmul(v10_real, r01));
+                    v10_real_new = vfnmadd(v01_imag, i10, vfmadd(v01_real, r10, v10_real_new));
+                    vreg v10_imag_new = vfmadd(v10_imag, r01, vmul(v10_real, i01));
+                    v10_imag_new = vfmadd(v01_imag, r10, vfmadd(v01_real, i10, v10_imag_new));
+                    vscatter(local_real, s10, v10_real_new);
+                    vscatter(local_imag, s10, v10_imag_new);
+
+                    idx = vidx_add(idx, inc);
+                }
+
+#else
+                int mask_inner = (1 << (local2 - 2)) - (1 << low_bit);
+                int mask_outer = (1 << (local2 - 1)) - (1 << high_bit);
+                for (int j = 0; j < m; j++) {
+                    int s00 = j + (j & mask_inner);
+                    s00 = s00 + (s00 & mask_outer);
+                    int s01 = s00 | (1 << controlQubit);
+                    int s10 = s00 | (1 << targetQubit);
+                    int s11 = s01 | s10;
+
+                    local_cpx val00 = CPXL(s00);
+                    local_cpx val01 = CPXL(s01);
+                    local_cpx val10 = CPXL(s10);
+                    local_cpx val11 = CPXL(s11);
+
+                    local_cpx val00_new = val00 * local_cpx(gate.r00, gate.i00) + val11 * local_cpx(gate.r11, gate.i11);
+                    local_cpx val01_new = val01 * local_cpx(gate.r01, gate.i01) + val10 * local_cpx(gate.r10, gate.i10);
+                    local_cpx val10_new = val01 * local_cpx(gate.r10, gate.i10) + val10 * local_cpx(gate.r01, gate.i01);
+                    local_cpx val11_new = val00 * local_cpx(gate.r11, gate.i11) + val11 * local_cpx(gate.r00, gate.i00);
+
+                    CPXS(s00, val00_new)
+                    CPXS(s01, val01_new)
+                    CPXS(s10, val10_new)
+                    CPXS(s11, val11_new)
+                }
+                low_bit++; high_bit++;
+                mask_inner = (1 << (local2 - 2)) - (1 << low_bit);
+                mask_outer = (1 << (local2 - 1)) - (1 << high_bit);
+
+                for (int j = 0; j < m; j++) {
+                    int s00 = j + (j & mask_inner);
+                    s00 = s00 + (s00 & mask_outer);
+                    int s01 = s00 | (1 << (controlQubit + 1));
+                    int s10 = s00 | (1 << (targetQubit + 1));
+                    int s11 = s01 | s10;
+
+                    local_cpx val00 = CPXL(s00);
+                    local_cpx val01 = CPXL(s01);
+                    local_cpx val10 = CPXL(s10);
+                    local_cpx val11 = CPXL(s11);
+
+                    local_cpx val00_new = val00 * local_cpx(gate.r00, -gate.i00) + val11 * local_cpx(gate.r11, -gate.i11);
+                    local_cpx val01_new = val01 * local_cpx(gate.r01, -gate.i01) + val10 * local_cpx(gate.r10, -gate.i10);
+                    local_cpx val10_new = val01 * local_cpx(gate.r10, -gate.i10) + val10 * local_cpx(gate.r01, -gate.i01);
+                    local_cpx val11_new = val00 * local_cpx(gate.r11, -gate.i11) + val11 * local_cpx(gate.r00, -gate.i00);
+
+                    CPXS(s00, val00_new)
+                    CPXS(s01, val01_new)
+                    CPXS(s10, val10_new)
+                    CPXS(s11, val11_new)
+                }
+#endif
+            } else { // controlled gate
+                controlQubit *= 2;
+                targetQubit *= 2;
+                int m = 1 << (local2 - 2);
+                int low_bit = std::min(controlQubit, targetQubit);
+                int high_bit = std::max(controlQubit, targetQubit);
+#ifdef USE_AVX512
+                vidx mask_inner = vidx_set1((1 << (local2 - 2)) - (1 << low_bit));
+                vidx mask_outer = vidx_set1((1 << (local2 - 1)) - (1 << high_bit));
+                vidx ctr_flag = vidx_set1(1 << controlQubit);
+                vidx tar_flag = vidx_set1(1 << targetQubit);
+                assert(m % VLEN == 0);
+                vidx idx = vidx_iota();
+                const vidx inc = vidx_set1(VLEN);
+                for (int j = 0; j < m; j += VLEN) {
+                    vidx lo = vidx_add(idx, vidx_and(idx, mask_inner));
+                    lo = vidx_add(lo, vidx_and(lo, mask_outer));
+                    lo = vidx_add(lo, ctr_flag);
+                    vidx hi = vidx_add(lo, tar_flag);
+                    // lo = vidx_add(lo, lo);
+                    // hi = vidx_add(hi, hi);
+                    vreg lo_real = vgather(lo, local_real);
+                    vreg lo_imag = vgather(lo, local_imag);
+                    vreg hi_real = vgather(hi, local_real);
+                    vreg hi_imag = vgather(hi, local_imag);
+                    vreg r00 = vset1(gate.r00);
+                    vreg i00 = vset1(gate.i00);
+                    vreg r01 = vset1(gate.r01);
+                    vreg i01 = vset1(gate.i01);
+                    vreg lo_real_new = vfnmadd(lo_imag, i00, vmul(lo_real, r00));
+                    lo_real_new = vfnmadd(hi_imag, i01, vfmadd(hi_real, r01, lo_real_new));
+                    vreg lo_imag_new = vfmadd(lo_imag, r00, vmul(lo_real, i00));
+                    lo_imag_new = vfmadd(hi_imag, r01, vfmadd(hi_real, i01, lo_imag_new));
+                    vscatter(local_real, lo, lo_real_new);
+                    vscatter(local_imag, lo, lo_imag_new);
+                    vreg r10 = vset1(gate.r10);
+                    vreg i10 = vset1(gate.i10);
+                    vreg hi_real_new = vfnmadd(lo_imag, i10, vmul(lo_real, r10));
+                    vreg r11 = vset1(gate.r11);
+                    vreg i11 = vset1(gate.i11);
+                    hi_real_new = vfnmadd(hi_imag, i11, vfmadd(hi_real, r11, hi_real_new));
+                    vreg hi_imag_new = vfmadd(lo_imag, r10, vmul(lo_real, i10));
+                    hi_imag_new = vfmadd(hi_imag, r11, vfmadd(hi_real, i11, hi_imag_new));
+                    vscatter(local_real, hi, hi_real_new);
+                    vscatter(local_imag, hi, hi_imag_new);
+                    idx = vidx_add(idx, inc);
+                }
+                low_bit++; high_bit++;
+                mask_inner = vidx_set1((1 << (local2 - 2)) - (1 << low_bit));
+                mask_outer = vidx_set1((1 << (local2 - 1)) - (1 << high_bit));
+                ctr_flag = vidx_set1(1 << (controlQubit + 1));
+                tar_flag = vidx_set1(1 << (targetQubit + 1));
+                assert(m % VLEN == 0);
+                idx = vidx_iota();
+                for (int j = 0; j < m; j += VLEN) {
+                    vidx lo = vidx_add(idx, vidx_and(idx, mask_inner));
+                    lo = vidx_add(lo, vidx_and(lo, mask_outer));
+                    lo = vidx_add(lo, ctr_flag);
+                    vidx hi = vidx_add(lo, tar_flag);
+                    // lo = vidx_add(lo, lo);
+                    // hi = vidx_add(hi, hi);
+                    vreg lo_real = vgather(lo, local_real);
+                    vreg lo_imag = vgather(lo, local_imag);
+                    vreg hi_real = vgather(hi, local_real);
+                    vreg hi_imag = vgather(hi, local_imag);
+                    vreg r00 = vset1(gate.r00);
+                    vreg i00 = vset1(-gate.i00);
+                    vreg r01 = vset1(gate.r01);
+                    vreg i01 = vset1(-gate.i01);
+                    vreg lo_real_new = vfnmadd(lo_imag, i00, vmul(lo_real, r00));
+                    lo_real_new = vfnmadd(hi_imag, i01, vfmadd(hi_real, r01, lo_real_new));
+                    vreg lo_imag_new = vfmadd(lo_imag, r00, vmul(lo_real, i00));
+                    lo_imag_new = vfmadd(hi_imag, r01, vfmadd(hi_real, i01, lo_imag_new));
+                    vscatter(local_real, lo, lo_real_new);
+                    vscatter(local_imag, lo, lo_imag_new);
+                    vreg r10 = vset1(gate.r10);
+                    vreg i10 = vset1(-gate.i10);
+                    vreg hi_real_new = vfnmadd(lo_imag, i10, vmul(lo_real, r10));
+                    vreg r11 = vset1(gate.r11);
+                    vreg i11 = vset1(-gate.i11);
+                    hi_real_new = vfnmadd(hi_imag, i11, vfmadd(hi_real, r11, hi_real_new));
+                    vreg hi_imag_new = vfmadd(lo_imag, r10, vmul(lo_real, i10));
+                    hi_imag_new = vfmadd(hi_imag, r11, vfmadd(hi_real, i11, hi_imag_new));
+                    vscatter(local_real, hi, hi_real_new);
+                    vscatter(local_imag, hi, hi_imag_new);
+                    idx = vidx_add(idx, inc);
+                }
+#else
+                int mask_inner = (1 << (local2 - 2)) - (1 << low_bit);
+                int mask_outer = (1 << (local2 - 1)) - (1 << high_bit);
+                for (int j = 0; j < m; j++) {
+                    int s0 = j + (j & mask_inner);
+                    s0 = s0 + (s0 & mask_outer);
+                    s0 |= (1 << controlQubit);
+                    int s1 = s0 | (1 << targetQubit);
+                    local_cpx val0 = CPXL(s0);
+                    local_cpx val1 = CPXL(s1);
+                    local_cpx val0_new = val0 * local_cpx(gate.r00, gate.i00) + val1 * local_cpx(gate.r01, gate.i01);
+                    local_cpx val1_new = val0 * local_cpx(gate.r10, gate.i10) + val1 * local_cpx(gate.r11, gate.i11);
+                    CPXS(s0, val0_new)
+                    CPXS(s1, val1_new)
+                }
+
+                low_bit++; high_bit++;
+                mask_inner = (1 << (local2 - 2)) - (1 << low_bit);
+                mask_outer = (1 << (local2 - 1)) - (1 << high_bit);
+
+                for (int j = 0; j < m; j++) {
+                    int s0 = j + (j & mask_inner);
+                    s0 = s0 + (s0 & mask_outer);
+                    s0 |= (1 << (controlQubit + 1));
+                    int s1 = s0 | (1 << (targetQubit + 1));
+                    local_cpx val0 = CPXL(s0);
+                    local_cpx val1 = CPXL(s1);
+                    local_cpx val0_new = val0 * local_cpx(gate.r00, -gate.i00) + val1 * local_cpx(gate.r01, -gate.i01);
+                    local_cpx val1_new = val0 * local_cpx(gate.r10, -gate.i10) + val1 * local_cpx(gate.r11, -gate.i11);
+                    CPXS(s0, val0_new)
+                    CPXS(s1, val1_new)
+                }
+#endif
+            }
+        }
+        if (hostGates[i].err_len_target > 0) {
+            int m = 1 << (local2 - 2);
+            int qid = hostGates[i].targetQubit * 2;
+            int numErrors = hostGates[i].err_len_target;
+#ifdef USE_AVX512
+            vidx mask_inner = vidx_set1((1 << (local2 - 2)) - (1 << qid));
+            const vidx inc = vidx_set1(VLEN);
+            const vidx inner_flag = vidx_set1(1 << qid);
+            const vidx outer_flag = vidx_set1(1 << (qid + 1));
+            vidx idx = vidx_iota();
+            for (int j = 0; j < m; j += VLEN) {
+                vidx tmp = vidx_and(idx, mask_inner);
+                vidx s00 = vidx_add(idx, vidx_add(tmp, vidx_add(tmp, tmp))); // _mm256_mul_epi32 only multiplies 4 values
+                vidx s01 = vidx_add(s00, inner_flag);
+                vidx s10 = vidx_add(s00, outer_flag);
+                vidx s11 = vidx_or(s01, s10);
+                GATHER(val00_real, val00_imag, s00)
+                GATHER(val01_real, val01_imag, s01)
+                GATHER(val10_real, val10_imag, s10)
+                GATHER(val11_real, val11_imag, s11)
+                NEW_ZERO_REG(sum00_real)
+                NEW_ZERO_REG(sum00_imag)
+                NEW_ZERO_REG(sum01_real)
+                NEW_ZERO_REG(sum01_imag)
+                NEW_ZERO_REG(sum10_real)
+                NEW_ZERO_REG(sum10_imag)
+                NEW_ZERO_REG(sum11_real)
+                NEW_ZERO_REG(sum11_imag)
+
+                for (int k = 0; k < numErrors; k++) {
+                    cpx (*e)[2] = hostGates[i].errs_target[k];
+                    LD_REG(e00_real, e00_imag, e[0][0]);
+                    LD_REG(e01_real, e01_imag, e[0][1]);
+                    LD_REG(e10_real, e10_imag, e[1][0]);
+                    LD_REG(e11_real, e11_imag, e[1][1]);
+                    CALC_AB_ADD_CD(w00_real, w00_imag, e00_real, e00_imag, val00_real, val00_imag, e01_real, e01_imag, val10_real, val10_imag);
+                    CALC_AB_ADD_CD(w01_real, w01_imag, e00_real, e00_imag, val01_real, val01_imag, e01_real, e01_imag, val11_real, val11_imag);
+                    CALC_AB_ADD_CD(w10_real, w10_imag, e10_real, e10_imag, val00_real, val00_imag, e11_real, e11_imag, val10_real, val10_imag);
+                    CALC_AB_ADD_CD(w11_real, w11_imag, e10_real, e10_imag, val01_real, val01_imag, e11_real, e11_imag, val11_real, val11_imag);
+                    CALC_ADD_AB_ADD_CD_NT(sum00_real, sum00_imag, w00_real, w00_imag, e00_real, e00_imag, w01_real, w01_imag, e01_real, e01_imag);
+                    CALC_ADD_AB_ADD_CD_NT(sum01_real, sum01_imag, w00_real, w00_imag, e10_real, e10_imag, w01_real, w01_imag, e11_real, e11_imag);
+                    CALC_ADD_AB_ADD_CD_NT(sum10_real, sum10_imag, w10_real, w10_imag, e00_real, e00_imag, w11_real, w11_imag, e01_real, e01_imag);
+                    CALC_ADD_AB_ADD_CD_NT(sum11_real, sum11_imag, w10_real, w10_imag, e10_real, e10_imag, w11_real, w11_imag, e11_real, e11_imag);
+                }
+                SCATTER(sum00_real, sum00_imag, s00);
+                SCATTER(sum01_real, sum01_imag, s01);
+                SCATTER(sum10_real, sum10_imag, s10);
+                SCATTER(sum11_real, sum11_imag, s11);
+                idx = vidx_add(idx, inc);
+            }
+#else
+            int mask_inner = (1 << (local2 - 2)) - (1 << qid);
+            for (int j = 0; j < m; j++) {
+                int s00 = j + (j & mask_inner) * 3;
+                int s01 = s00 | (1 << qid);
+                int s10 = s00 | (1 << (qid + 1));
+                int s11 = s01 | s10;
+                local_cpx val00 = CPXL(s00);
+                local_cpx val01 = CPXL(s01);
+                local_cpx val10 = CPXL(s10);
+                local_cpx val11 = CPXL(s11);
+
+                local_cpx sum00 = local_cpx(0.0), sum01 = local_cpx(0.0), sum10 = local_cpx(0.0), sum11=local_cpx(0.0);
+                for (int k = 0; k < numErrors; k++) {
+                    cpx (*err)[2] = hostGates[i].errs_target[k];
+                    local_cpx e[2][2] = {{err[0][0], err[0][1]}, {err[1][0], err[1][1]}};
+                    local_cpx w00 = e[0][0] * val00 + e[0][1] * val10;
+                    local_cpx w01 = e[0][0] * val01 + e[0][1] * val11;
+                    local_cpx w10 = e[1][0] * val00 + e[1][1] * val10;
+                    local_cpx w11 = e[1][0] * val01 + e[1][1] * val11;
+                    sum00 += w00 * std::conj(e[0][0]) + w01 * std::conj(e[0][1]);
+                    sum01 += w00 * std::conj(e[1][0]) + w01 * std::conj(e[1][1]);
+                    sum10 += w10 * std::conj(e[0][0]) + w11 * std::conj(e[0][1]);
+                    sum11 += w10 * std::conj(e[1][0]) + w11 * std::conj(e[1][1]);
+                }
+
+                CPXS(s00, sum00)
+                CPXS(s01, sum01)
+                CPXS(s10, sum10)
+                CPXS(s11, sum11)
+            }
+#endif
+        }
+        if (hostGates[i].err_len_control > 0) {
+            int m = 1 << (LOCAL_QUBIT_SIZE * 2 - 2);
+            int qid = hostGates[i].controlQubit == -3? hostGates[i].encodeQubit: hostGates[i].controlQubit;
+            qid *= 2;
+            int numErrors = hostGates[i].err_len_control;
+#ifdef USE_AVX512
+            vidx mask_inner = vidx_set1((1 << (local2 - 2)) - (1 << qid));
+            const vidx inc = vidx_set1(VLEN);
+            const vidx inner_flag = vidx_set1(1 << qid);
+            const vidx outer_flag = vidx_set1(1 << (qid + 1));
+            vidx idx = vidx_iota();
+            for (int j = 0; j < m; j += VLEN) {
+                vidx tmp = vidx_and(idx, mask_inner);
+                vidx s00 = vidx_add(idx, vidx_add(tmp, vidx_add(tmp, tmp))); // _mm256_mul_epi32 only multiplies 4 values
+                vidx s01 = vidx_add(s00, inner_flag);
+                vidx s10 = vidx_add(s00, outer_flag);
+                vidx s11 = vidx_or(s01, s10);
+                GATHER(val00_real, val00_imag, s00)
+                GATHER(val01_real, val01_imag, s01)
+                GATHER(val10_real, val10_imag, s10)
+                GATHER(val11_real, val11_imag, s11)
+                NEW_ZERO_REG(sum00_real)
+                NEW_ZERO_REG(sum00_imag)
+                NEW_ZERO_REG(sum01_real)
+                NEW_ZERO_REG(sum01_imag)
+                NEW_ZERO_REG(sum10_real)
+                NEW_ZERO_REG(sum10_imag)
+                NEW_ZERO_REG(sum11_real)
+                NEW_ZERO_REG(sum11_imag)
+
+                for (int k = 0; k < numErrors; k++) {
+                    cpx (*e)[2] = hostGates[i].errs_control[k];
+                    LD_REG(e00_real, e00_imag, e[0][0]);
+                    LD_REG(e01_real, e01_imag, e[0][1]);
+                    LD_REG(e10_real, e10_imag, e[1][0]);
+                    LD_REG(e11_real, e11_imag, e[1][1]);
+                    CALC_AB_ADD_CD(w00_real, w00_imag, e00_real, e00_imag, val00_real, val00_imag, e01_real, e01_imag, val10_real, val10_imag);
+                    CALC_AB_ADD_CD(w01_real, w01_imag, e00_real, e00_imag, val01_real, val01_imag, e01_real, e01_imag, val11_real, val11_imag);
+                    CALC_AB_ADD_CD(w10_real, w10_imag, e10_real, e10_imag, val00_real, val00_imag, e11_real, e11_imag, val10_real, val10_imag);
+                    CALC_AB_ADD_CD(w11_real, w11_imag, e10_real, e10_imag, val01_real, val01_imag, e11_real, e11_imag, val11_real, val11_imag);
+                    CALC_ADD_AB_ADD_CD_NT(sum00_real, sum00_imag, w00_real, w00_imag, e00_real, e00_imag, w01_real, w01_imag, e01_real, e01_imag);
+                    CALC_ADD_AB_ADD_CD_NT(sum01_real, sum01_imag, w00_real, w00_imag, e10_real, e10_imag, w01_real, w01_imag, e11_real, e11_imag);
+                    CALC_ADD_AB_ADD_CD_NT(sum10_real, sum10_imag, w10_real, w10_imag, e00_real, e00_imag, w11_real, w11_imag, e01_real, e01_imag);
+                    CALC_ADD_AB_ADD_CD_NT(sum11_real, sum11_imag, w10_real, w10_imag, e10_real, e10_imag, w11_real, w11_imag, e11_real, e11_imag);
+                }
+                SCATTER(sum00_real, sum00_imag, s00);
+                SCATTER(sum01_real, sum01_imag, s01);
+                SCATTER(sum10_real, sum10_imag, s10);
+                SCATTER(sum11_real, sum11_imag, s11);
+                idx = vidx_add(idx, inc);
+            }
+#else
+            int mask_inner = (1 << (local2 - 2)) - (1 << qid);
+            for (int j = 0; j < m; j++) {
+                int s00 = j + (j & mask_inner) * 3;
+                int s01 = s00 | (1 << qid);
+                int s10 = s00 | (1 << (qid + 1));
+                int s11 = s01 | s10;
+                local_cpx val00 = CPXL(s00);
+                local_cpx val01 = CPXL(s01);
+                local_cpx val10 = CPXL(s10);
+                local_cpx val11 = CPXL(s11);
+
+                local_cpx sum00 = local_cpx(0.0), sum01 = local_cpx(0.0), sum10 = local_cpx(0.0), sum11=local_cpx(0.0);
+                for (int k = 0; k < numErrors; k++) {
+                    cpx (*err)[2] = hostGates[i].errs_control[k];
+                    local_cpx e[2][2] = {{err[0][0], err[0][1]}, {err[1][0], err[1][1]}};
+                    local_cpx w00 = e[0][0] * val00 + e[0][1] * val10;
+                    local_cpx w01 = e[0][0] * val01 + e[0][1] * val11;
+                    local_cpx w10 = e[1][0] * val00 + e[1][1] * val10;
+                    local_cpx w11 = e[1][0] * val01 + e[1][1] * val11;
+                    sum00 += w00 * std::conj(e[0][0]) + w01 * std::conj(e[0][1]);
+                    sum01 += w00 * std::conj(e[1][0]) + w01 * std::conj(e[1][1]);
+                    sum10 += w10 * std::conj(e[0][0]) + w11 * std::conj(e[0][1]);
+                    sum11 += w10 * std::conj(e[1][0]) + w11 * std::conj(e[1][1]);
+                }
+
+                CPXS(s00, sum00)
+                CPXS(s01, sum01)
+                CPXS(s10, sum10)
+                CPXS(s11, sum11)
+            }
+#endif
+        }
+    }
+#else
+    UNREACHABLE();
+#endif
+}
+
+void dmGroup(cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, int numLocalQubits) {
+    unsigned int related2 = duplicate_bit(relatedQubits); // warning: put it in master core
+    idx_t blockHot = (idx_t(1) << (numLocalQubits * 2)) - 1 - related2;
+    int numBlocks = 1 << ((numLocalQubits - LOCAL_QUBIT_SIZE) * 2);
+    bool stream = use_stream_stores(sizeof(cpx) << (numLocalQubits * 2));
+    #pragma omp parallel for
+    for (int blockID = 0; blockID < numBlocks; blockID++) {
+        local_t local_real[1 << (LOCAL_QUBIT_SIZE * 2)];
+        local_t local_imag[1 << (LOCAL_QUBIT_SIZE * 2)];
+        unsigned int bias = block_bias(blockID, blockHot);
+        fetch_data_dm(local_real, local_imag, sv, bias, related2);
+        if (blockID + 1 < numBlocks)
+            prefetch_data_dm(sv, block_bias(blockID + 1, blockHot), related2);
+        apply_gate_group_dm(local_real, local_imag, numGates, blockID, hostGates);
+        save_data_dm(sv, local_real, local_imag, bias, related2, stream);
+    }
+}
+
+}
+}
@@ -0,0 +1,3 @@
+#define KERNEL_ISA Scalar
+#include "cpu/kernel_sv.h"
+#include "cpu/kernel_dm.h"
@@ -0,0 +1,634 @@
+// State-vector group kernels. No include guard: this file is compiled once per
+// instruction set by kernel_{scalar,avx2,avx512}.cpp, which define KERNEL_ISA
+// (the namespace of this copy) and USE_AVX2 / USE_AVX512 before including it.
+#include "cpu/kernel.h"
+#include <cstring>
+#include <assert.h>
+#include <x86intrin.h>
+#include "cpu/simd.h"
+
+#ifndef FOLLOW_NEXT
+#define FOLLOW_NEXT(TYPE) \
+case GateType::TYPE: // no break
+#endif
+
+namespace CpuImpl {
+namespace KERNEL_ISA {
+
+// Offset of amplitude x in local_real / local_imag. With AOSOA_LAYOUT the local
+// buffer uses the blocked layout of the state vector (local_imag is local_real +
+// AOSOA_WIDTH), so fetch / save move whole blocks and a block that is already
+// contiguous in the state vector can be updated in place.
+#ifdef AOSOA_LAYOUT
+inline int local_at(int x) { return x + (x & ~(AOSOA_WIDTH - 1)); }
+#ifdef USE_SIMD
+static_assert(VLEN <= AOSOA_WIDTH, "a vector must not cross an AoSoA block");
+#endif
+#else
+inline int local_at(int x) { return x; }
+#endif
+
+#ifdef AOSOA_LAYOUT
+// The low related qubits (at least COALESCE_GLOBAL of them) form runs that are
+// contiguous both in the state vector and in the blocked local buffer, so each
+// run is moved by one straight copy.
+template<int LQS>
+inline int contiguous_run(idx_t relatedQubits) {
+    return std::min(__builtin_ctzll(~relatedQubits), LQS);
+}
+#endif
+
+template<int LQS>
+inline void fetch_data(local_t* local_real, local_t* local_imag, const cpx* deviceStateVec, int bias, idx_t relatedQubits) {
+    int x;
+    unsigned int y;
+#ifdef AOSOA_LAYOUT
+    int run = contiguous_run<LQS>(relatedQubits);
+#else
+    const int run = COALESCE_GLOBAL;
+#endif
+    idx_t mask = (1 << run) - 1;
+    assert((relatedQubits & mask) == mask);
+    relatedQubits -= mask;
+    for (x = (1 << LQS) - 1 - mask, y = relatedQubits; x >= 0; x -= (1 << run), y = relatedQubits & (y-1)) {
+#ifdef AOSOA_LAYOUT
+        // same blocked layout on both sides: a run is 2 << run consecutive scalars
+        const value_t* blk = aosoa_block(deviceStateVec, bias | y);
+        local_t* dst = local_real + local_at(x);
+        #pragma ivdep
+        for (int i = 0; i < (2 << run); i++)
+            dst[i] = blk[i];
+#else
+        #pragma ivdep
+        for (int i = 0; i < (1 << run); i++) {
+            local_real[x + i] = deviceStateVec[(bias | y) + i].real();
+            local_imag[x + i] = deviceStateVec[(bias | y) + i].imag();
+            // printf("fetch %d <- %d\n", x + i, (bias | y) + i);
+        }
+#endif
+    }
+}
+
+template<int LQS>
+inline void save_data(cpx* deviceStateVec, const local_t* local_real, const local_t* local_imag, int bias, idx_t relatedQubits, bool stream) {
+    int x;
+    unsigned int y;
+#ifdef AOSOA_LAYOUT
+    int run = contiguous_run<LQS>(relatedQubits);
+#else
+    const int run = COALESCE_GLOBAL;
+#endif
+    stream = stream && (1 << run) >= STREAM_MIN_CPX;
+    idx_t mask = (1 << run) - 1;
+    assert((relatedQubits & mask) == mask);
+    relatedQubits -= mask;
+    for (x = (1 << LQS) - 1 - mask, y = relatedQubits; x >= 0; x -= (1 << run), y = relatedQubits & (y-1)) {
+#ifdef AOSOA_LAYOUT
+        value_t* blk = aosoa_block(deviceStateVec, bias | y);
+        const local_t* src = local_real + local_at(x);
+        if (stream) {
+            stream_scalar(blk, src, 2 << run);
+            continue;
+        }
+        #pragma ivdep
+        for (int i = 0; i < (2 << run); i++)
+            blk[i] = src[i];
+#else
+        if (stream) {
+            stream_cpx(deviceStateVec + (bias | y), local_real + x, local_imag + x, 1 << run);
+            continue;
+        }
+        #pragma ivdep
+        for (int i = 0; i < (1 << run); i++) {
+            deviceStateVec[(bias | y) + i].real(local_real[x + i]);
+            deviceStateVec[(bias | y) + i].imag(local_imag[x + i]);
+        }
+#endif
+    }
+    if (stream)
+        _mm_sfence();
+}
+
+// pull the runs of the block at bias towards L2 while the current block computes
+template<int LQS>
+inline void prefetch_data(const cpx* deviceStateVec, int bias, idx_t relatedQubits) {
+#ifdef AOSOA_LAYOUT
+    int run = contiguous_run<LQS>(relatedQubits);
+#else
+    const int run = COALESCE_GLOBAL;
+#endif
+    idx_t mask = (1 << run) - 1;
+    relatedQubits -= mask;
+    unsigned int y = relatedQubits;
+    for (int x = (1 << LQS) - 1 - mask; x >= 0; x -= (1 << run), y = relatedQubits & (y-1))
+        prefetch_l2(deviceStateVec + (bias | y), sizeof(cpx) << run);
+}
+
+// Stride-aware traversal of the pairs (lo, lo | 1 << targetQubit) of the local
+// buffer whose bits in ctrlMask equal ctrlVal. When the target stride is at least
+// the vector width, the lo and hi lanes of one iteration are two contiguous runs
+// and are read with plain vector loads. Smaller targets load two adjacent vectors
+// and split them into lo and hi lanes with in-register permutes. op updates
+// (lo_real, lo_imag, hi_real, hi_imag) in place. Lanes that do not match the
+// control pattern are blended back to their old values. Control bits above the
+// span of one iteration are tested once per iteration instead.
+#ifdef USE_SIMD
+template<int LQS, typename Op>
+inline void for_each_pair(local_t* local_real, local_t* local_imag, int targetQubit, int ctrlMask, int ctrlVal, Op op) {
+    bool contiguous = (1 << targetQubit) >= VLEN;
+    int span = contiguous ? VLEN : VLEN * 2;
+    int laneMask = ctrlMask & (span - 1);
+    int baseMask = ctrlMask - laneMask;
+    int baseVal = ctrlVal & baseMask;
+    if (contiguous) {
+        int bits = 0;
+        for (int k = 0; k < VLEN; k++)
+            if ((k & laneMask) == (ctrlVal & laneMask))
+                bits |= 1 << k;
+        vmask active = vmask_from_bits(bits);
+        int m = 1 << (LQS - 1);
+        int mask_inner = (1 << (LQS - 1)) - (1 << targetQubit);
+        for (int j = 0; j < m; j += VLEN) {
+            int lo = j + (j & mask_inner);
+            if ((lo & baseMask) != baseVal) continue;
+            int hi = lo + (1 << targetQubit);
+            vreg lo_real = vload(local_real + local_at(lo));
+            vreg lo_imag = vload(local_imag + local_at(lo));
+            vreg hi_real = vload(local_real + local_at(hi));
+            vreg hi_imag = vload(local_imag + local_at(hi));
+            vreg lo_real_new = lo_real, lo_imag_new = lo_imag, hi_real_new = hi_real, hi_imag_new = hi_imag;
+            op(lo_real_new, lo_imag_new, hi_real_new, hi_imag_new);
+            vstore(local_real + local_at(lo), vblend(active, lo_real, lo_real_new));
+            vstore(local_imag + local_at(lo), vblend(active, lo_imag, lo_imag_new));
+            vstore(local_real + local_at(hi), vblend(active, hi_real, hi_real_new));
+            vstore(local_imag + local_at(hi), vblend(active, hi_imag, hi_imag_new));
+        }
+        return;
+    }
+    PairSplit pairs(targetQubit);
+    int bits = 0;
+    for (int k = 0; k < VLEN; k++)
+        if ((pairs.lanePos[k] & laneMask) == (ctrlVal & laneMask))
+            bits |= 1 << k;
+    vmask active = vmask_from_bits(bits);
+    for (int x = 0; x < (1 << LQS); x += VLEN * 2) {
+        if ((x & baseMask) != baseVal) continue;
+        vreg lo_real, lo_imag, hi_real, hi_imag;
+        pairs.split(vload(local_real + local_at(x)), vload(local_real + local_at(x + VLEN)), lo_real, hi_real);
+        pairs.split(vload(local_imag + local_at(x)), vload(local_imag + local_at(x + VLEN)), lo_imag, hi_imag);
+        vreg lo_real_new = lo_real, lo_imag_new = lo_imag, hi_real_new = hi_real, hi_imag_new = hi_imag;
+        op(lo_real_new, lo_imag_new, hi_real_new, hi_imag_new);
+        lo_real = vblend(active, lo_real, lo_real_new);
+        lo_imag = vblend(active, lo_imag, lo_imag_new);
+        hi_real = vblend(active, hi_real, hi_real_new);
+        hi_imag = vblend(active, hi_imag, hi_imag_new);
+        vreg v0, v1;
+        pairs.merge(lo_real, hi_real, v0, v1);
+        vstore(local_real + local_at(x), v0);
+        vstore(local_real + local_at(x + VLEN), v1);
+        pairs.merge(lo_imag, hi_imag, v0, v1);
+        vstore(local_imag + local_at(x), v0);
+        vstore(local_imag + local_at(x + VLEN), v1);
+    }
+}
+#endif
+
+// specialized kernels for single-qubit gates whose matrix has a known shape,
+// the pairs are (lo, lo | 1 << targetQubit) for all lo with bit targetQubit clear
+// and (lo & ctrlMask) == ctrlVal
+
+// multiply every amplitude of the local buffer by r + i * 1j
+template<int LQS>
+inline void apply_phase_all(local_t* local_real, local_t* local_imag, local_t r, local_t i) {
+    int m = 1 << LQS;
+    #ifdef USE_SIMD
+    vreg rr = vset1(r);
+    vreg ii = vset1(i);
+    for (int j = 0; j < m; j += VLEN) {
+        vreg x_real = vload(local_real + local_at(j));
+        vreg x_imag = vload(local_imag + local_at(j));
+        vreg x_real_new = vfnmadd(x_imag, ii, vmul(x_real, rr));
+        vreg x_imag_new = vfmadd(x_imag, rr, vmul(x_real, ii));
+        vstore(local_real + local_at(j), x_real_new);
+        vstore(local_imag + local_at(j), x_imag_new);
+    }
+    #else
+    local_cpx param = local_cpx(r, i);
+    #pragma ivdep
+    for (int j = 0; j < m; j++) {
+        local_cpx new_val = local_cpx(local_real[local_at(j)], local_imag[local_at(j)]) * param;
+        local_real[local_at(j)] = new_val.real();
+        local_imag[local_at(j)] = new_val.imag();
+    }
+    #endif
+}
+
+// X: swap lo and hi, no arithmetic
+template<int LQS>
+inline void apply_x_single(local_t* local_real, local_t* local_imag, int targetQubit) {
+    #ifdef USE_SIMD
+    for_each_pair<LQS>(local_real, local_imag, targetQubit, 0, 0, [](vreg& lo_real, vreg& lo_imag, vreg& hi_real, vreg& hi_imag) {
+        std::swap(lo_real, hi_real);
+        std::swap(lo_imag, hi_imag);
+    });
+    #else
+    int m = 1 << (LQS - 1);
+    int mask_inner = (1 << (LQS - 1)) - (1 << targetQubit);
+    #pragma ivdep
+    for (int j = 0; j < m; j++) {
+        int lo = j + (j & mask_inner);
+        int hi = lo | (1 << targetQubit);
+        std::swap(local_real[local_at(lo)], local_real[local_at(hi)]);
+        std::swap(local_imag[local_at(lo)], local_imag[local_at(hi)]);
+    }
+    #endif
+}
+
+// H: lo, hi = s * (lo + hi), s * (lo - hi)
+template<int LQS>
+inline void apply_h_single(local_t* local_real, local_t* local_imag, int targetQubit, local_t s) {
+    #ifdef USE_SIMD
+    vreg ss = vset1(s);
+    for_each_pair<LQS>(local_real, local_imag, targetQubit, 0, 0, [&](vreg& lo_real, vreg& lo_imag, vreg& hi_real, vreg& hi_imag) {
+        vreg lo_real_new = vmul(vadd(lo_real, hi_real), ss);
+        vreg lo_imag_new = vmul(vadd(lo_imag, hi_imag), ss);
+        hi_real = vmul(vsub(lo_real, hi_real), ss);
+        hi_imag = vmul(vsub(lo_imag, hi_imag), ss);
+        lo_real = lo_real_new;
+        lo_imag = lo_imag_new;
+    });
+    #else
+    int m = 1 << (LQS - 1);
+    int mask_inner = (1 << (LQS - 1)) - (1 << targetQubit);
+    #pragma ivdep
+    for (int j = 0; j < m; j++) {
+        int lo = j + (j & mask_inner);
+        int hi = lo | (1 << targetQubit);
+        local_t lo_real = local_real[local_at(lo)], lo_imag = local_imag[local_at(lo)];
+        local_t hi_real = local_real[local_at(hi)], hi_imag = local_imag[local_at(hi)];
+        local_real[local_at(lo)] = (lo_real + hi_real) * s;
+        local_imag[local_at(lo)] = (lo_imag + hi_imag) * s;
+        local_real[local_at(hi)] = (lo_real - hi_real) * s;
+        local_imag[local_at(hi)] = (lo_imag - hi_imag) * s;
+    }
+    #endif
+}
+
+// diagonal gates: lo *= r0 + i0 * 1j, hi *= r1 + i1 * 1j. With loFlag == false
+// the lo half is known to be multiplied by 1 and is left as it is.
+template<int LQS>
+inline void apply_diag_single(local_t* local_real, local_t* local_imag, int targetQubit, bool loFlag, local_t r0, local_t i0, local_t r1, local_t i1, int ctrlMask, int ctrlVal) {
+    #ifdef USE_SIMD
+    vreg rr0 = vset1(r0);
+    vreg ii0 = vset1(i0);
+    vreg rr1 = vset1(r1);
+    vreg ii1 = vset1(i1);
+    for_each_pair<LQS>(local_real, local_imag, targetQubit, ctrlMask, ctrlVal, [&](vreg& lo_real, vreg& lo_imag, vreg& hi_real, vreg& hi_imag) {
+        if (loFlag) {
+            vreg lo_real_new = vfnmadd(lo_imag, ii0, vmul(lo_real, rr0));
+            lo_imag = vfmadd(lo_imag, rr0, vmul(lo_real, ii0));
+            lo_real = lo_real_new;
+        }
+        vreg hi_real_new = vfnmadd(hi_imag, ii1, vmul(hi_real, rr1));
+        hi_imag = vfmadd(hi_imag, rr1, vmul(hi_real, ii1));
+        hi_real = hi_real_new;
+    });
+    #else
+    int m = 1 << (LQS - 1);
+    int mask_inner = (1 << (LQS - 1)) - (1 << targetQubit);
+    local_cpx param0 = local_cpx(r0, i0), param1 = local_cpx(r1, i1);
+    #pragma ivdep
+    for (int j = 0; j < m; j++) {
+        int lo = j + (j & mask_inner);
+        int hi = lo | (1 << targetQubit);
+        if ((lo & ctrlMask) != ctrlVal) continue;
+        if (loFlag) {
+            local_cpx lo_val = local_cpx(local_real[local_at(lo)], local_imag[local_at(lo)]) * param0;
+            local_real[local_at(lo)] = lo_val.real();
+            local_imag[local_at(lo)] = lo_val.imag();
+        }
+        local_cpx hi_val = local_cpx(local_real[local_at(hi)], local_imag[local_at(hi)]) * param1;
+        local_real[local_at(hi)] = hi_val.real();
+        local_imag[local_at(hi)] = hi_val.imag();
+    }
+    #endif
+}
+
+// multiply the amplitudes whose bits in ctrlMask are all set by r + i * 1j
+template<int LQS>
+inline void apply_ctrl_phase(local_t* local_real, local_t* local_imag, int ctrlMask, local_t r, local_t i) {
+    if (ctrlMask == 0) {
+        apply_phase_all<LQS>(local_real, local_imag, r, i);
+        return;
+    }
+    // use the lowest control as the target of a U1-like gate controlled by the others
+    int t = __builtin_ctz(ctrlMask);
+    int rest = ctrlMask & (ctrlMask - 1);
+    apply_diag_single<LQS>(local_real, local_imag, t, false, 1, 0, r, i, rest, rest);
+}
+
+// generic 2x2 complex matrix
+template<int LQS>
+inline void apply_matrix_single(local_t* local_real, local_t* local_imag, int targetQubit, int ctrlMask, int ctrlVal, const KernelGate& gate) {
+    #ifdef USE_SIMD
+    vreg r00 = vset1(gate.r00);
+    vreg i00 = vset1(gate.i00);
+    vreg r01 = vset1(gate.r01);
+    vreg i01 = vset1(gate.i01);
+    vreg r10 = vset1(gate.r10);
+    vreg i10 = vset1(gate.i10);
+    vreg r11 = vset1(gate.r11);
+    vreg i11 = vset1(gate.i11);
+    for_each_pair<LQS>(local_real, local_imag, targetQubit, ctrlMask, ctrlVal, [&](vreg& lo_real, vreg& lo_imag, vreg& hi_real, vreg& hi_imag) {
+        vreg lo_real_new = vfnmadd(lo_imag, i00, vmul(lo_real, r00));
+        lo_real_new = vfnmadd(hi_imag, i01, vfmadd(hi_real, r01, lo_real_new));
+        vreg lo_imag_new = vfmadd(lo_imag, r00, vmul(lo_real, i00));
+        lo_imag_new = vfmadd(hi_imag, r01, vfmadd(hi_real, i01, lo_imag_new));
+        vreg hi_real_new = vfnmadd(lo_imag, i10, vmul(lo_real, r10));
+        hi_real_new = vfnmadd(hi_imag, i11, vfmadd(hi_real, r11, hi_real_new));
+        vreg hi_imag_new = vfmadd(lo_imag, r10, vmul(lo_real, i10));
+        hi_imag_new = vfmadd(hi_imag, r11, vfmadd(hi_real, i11, hi_imag_new));
+        lo_real = lo_real_new;
+        lo_imag = lo_imag_new;
+        hi_real = hi_real_new;
+        hi_imag = hi_imag_new;
+    });
+    #else
+    int m = 1 << (LQS - 1);
+    int mask_inner = (1 << (LQS - 1)) - (1 << targetQubit);
+    #pragma ivdep
+    for (int j = 0; j < m; j++) {
+        int lo = j + (j & mask_inner);
+        int hi = lo | (1 << targetQubit);
+        if ((lo & ctrlMask) != ctrlVal) continue;
+        local_cpx lo_val = local_cpx(local_real[local_at(lo)], local_imag[local_at(lo)]);
+        local_cpx hi_val = local_cpx(local_real[local_at(hi)], local_imag[local_at(hi)]);
+        local_cpx lo_val_new = lo_val * local_cpx(gate.r00, gate.i00) + hi_val * local_cpx(gate.r01, gate.i01);
+        local_real[local_at(lo)] = lo_val_new.real();
+        local_imag[local_at(lo)] = lo_val_new.imag();
+        local_cpx hi_val_new = lo_val * local_cpx(gate.r10, gate.i10) + hi_val * local_cpx(gate.r11, gate.i11);
+        local_real[local_at(hi)] = hi_val_new.real();
+        local_imag[local_at(hi)] = hi_val_new.imag();
+    }
+    #endif
+}
+
+// dispatch a single-qubit gate with a local target to a specialized kernel,
+// returns false if the generic 2x2 kernel should be used
+template<int LQS>
+inline bool apply_special_single(local_t* local_real, local_t* local_imag, const KernelGate& gate) {
+    int targetQubit = gate.targetQubit;
+    switch (gate.type) {
+        case GateType::ID:
+            return true;
+        FOLLOW_NEXT(CNOT)
+        case GateType::X:
+            apply_x_single<LQS>(local_real, local_imag, targetQubit);
+            return true;
+        case GateType::H:
+            apply_h_single<LQS>(local_real, local_imag, targetQubit, gate.r00);
+            return true;
+        FOLLOW_NEXT(CZ)
+        FOLLOW_NEXT(Z)
+        FOLLOW_NEXT(S)
+        FOLLOW_NEXT(SDG)
+        FOLLOW_NEXT(T)
+        FOLLOW_NEXT(TDG)
+        FOLLOW_NEXT(CU1)
+        FOLLOW_NEXT(GOC)
+        case GateType::U1:
+            apply_diag_single<LQS>(local_real, local_imag, targetQubit, false, 1, 0, gate.r11, gate.i11, 0, 0);
+            return true;
+        FOLLOW_NEXT(RZ)
+        FOLLOW_NEXT(CRZ)
+        case GateType::DIG:
+            apply_diag_single<LQS>(local_real, local_imag, targetQubit, true, gate.r00, gate.i00, gate.r11, gate.i11, 0, 0);
+            return true;
+        FOLLOW_NEXT(GII)
+        FOLLOW_NEXT(GZZ)
+        case GateType::GCC:
+            apply_phase_all<LQS>(local_real, local_imag, gate.r00, gate.i00);
+            return true;
+        default:
+            return false;
+    }
+}
+
+template<int LQS>
+inline void apply_gate_group(local_t* local_real, local_t* local_imag, int numGates, int blockID, KernelGate hostGates[]) {
+    for (int i = 0; i < numGates; i++) {
+        auto& gate = hostGates[i];
+        int controlQubit = gate.controlQubit;
+        int targetQubit = gate.targetQubit;
+        char controlIsGlobal = gate.controlIsGlobal;
+        char targetIsGlobal = gate.targetIsGlobal;
+        if (controlQubit == -2) { // mcGate
+            // encodeQubit: controls in the local buffer at the low LQS bits, controls in blockID above
+            int blockMask = gate.encodeQubit >> LQS;
+            if ((blockID & blockMask) != blockMask) continue;
+            int localMask = gate.encodeQubit & ((1 << LQS) - 1);
+            if (gate.type == GateType::MCI) { // target is a global qubit, mat is diagonal
+                apply_ctrl_phase<LQS>(local_real, local_imag, localMask, gate.r00, gate.i00);
+            } else if (targetIsGlobal) { // target is in blockID, only diagonal gates get here
+                bool isHighBlock = (blockID >> targetQubit) & 1;
+                if (isHighBlock) {
+                    apply_ctrl_phase<LQS>(local_real, local_imag, localMask, gate.r11, gate.i11);
+                } else {
+                    apply_ctrl_phase<LQS>(local_real, local_imag, localMask, gate.r00, gate.i00);
+                }
+            } else {
+                apply_matrix_single<LQS>(local_real, local_imag, targetQubit, localMask, localMask, gate);
+            }
+        } else if (controlQubit == -3) { // RZZ: s00, s11 *= (r00, i00) and s01, s10 *= (r01, i01)
+            int encodeQubit = gate.encodeQubit;
+            if (!controlIsGlobal && !targetIsGlobal) {
+                apply_diag_single<LQS>(local_real, local_imag, targetQubit, true, gate.r00, gate.i00, gate.r01, gate.i01, 1 << encodeQubit, 0);
+                apply_diag_single<LQS>(local_real, local_imag, targetQubit, true, gate.r01, gate.i01, gate.r00, gate.i00, 1 << encodeQubit, 1 << encodeQubit);
+            } else if (controlIsGlobal && !targetIsGlobal) {
+                bool isHighBlock = (blockID >> encodeQubit) & 1;
+                if (!isHighBlock) {
+                    apply_diag_single<LQS>(local_real, local_imag, targetQubit, true, gate.r00, gate.i00, gate.r01, gate.i01, 0, 0);
+                } else {
+                    apply_diag_single<LQS>(local_real, local_imag, targetQubit, true, gate.r01, gate.i01, gate.r00, gate.i00, 0, 0);
+                }
+            } else {
+                UNIMPLEMENTED();
+            }
+        } else if (!controlIsGlobal) {
+            if (!targetIsGlobal) {
+                apply_matrix_single<LQS>(local_real, local_imag, targetQubit, 1 << controlQubit, 1 << controlQubit, gate);
+            } else {
+                assert(hostGates[i].type == GateType::CZ || hostGates[i].type == GateType::CU1 || hostGates[i].type == GateType::CRZ);
+                bool isHighBlock = (blockID >> targetQubit) & 1;
+                if (!isHighBlock) {
+                    if (hostGates[i].type == GateType::CRZ) {
+                        apply_ctrl_phase<LQS>(local_real, local_imag, 1 << controlQubit, gate.r00, gate.i00);
+                    }
+                } else {
+                    apply_ctrl_phase<LQS>(local_real, local_imag, 1 << controlQubit, gate.r11, gate.i11);
+                }
+            }
+        } else {
+            if (controlIsGlobal == 1 && !((blockID>> controlQubit) & 1)) {
+                continue;
+            }
+            if (!targetIsGlobal) {
+                if (apply_special_single<LQS>(local_real, local_imag, gate)) {
+                    continue;
+                }
+                apply_matrix_single<LQS>(local_real, local_imag, targetQubit, 0, 0, gate);
+            } else {
+                bool isHighBlock = (blockID >> targetQubit) & 1;
+                local_t re = isHighBlock ? gate.r11 : gate.r00;
+                local_t im = isHighBlock ? gate.i11 : gate.i00;
+                // the low block of Z/S/T/U1 and the like is left unchanged
+                if (re == 1 && im == 0) {
+                    continue;
+                }
+                apply_phase_all<LQS>(local_real, local_imag, re, im);
+            }
+        }
+    }
+}
+
+// Applies the group to numBlocks blocks: block blockID holds the amplitudes
+// bias0 | (blockID spread over the bits of blockHot) | (any related bits).
+// svGroup covers the whole state, svTiles the blocks of one tile. stream
+// writes the blocks back with non-temporal stores. A CPU_BIAS_TABLE build
+// reads the spread block ids from blockBias when the caller has one.
+template<int LQS>
+void svGroupBlock(cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, idx_t blockHot, unsigned int bias0, int numBlocks, bool parallel, bool stream, const unsigned int* blockBias) {
+#if defined(AOSOA_LAYOUT) && !defined(MIXED_PRECISION)
+    // the related qubits are the low qubits: each block is a contiguous run
+    // starting at its bias and already in the kernels' layout
+    bool inPlace = relatedQubits == (idx_t(1) << LQS) - 1;
+#endif
+    #pragma omp parallel for if(parallel)
+    for (int blockID = 0; blockID < numBlocks; blockID++) {
+#ifdef CPU_BIAS_TABLE
+        unsigned int bias = bias0 | (blockBias != nullptr ? blockBias[blockID] : block_bias(blockID, blockHot));
+#else
+        unsigned int bias = bias0 | block_bias(blockID, blockHot);
+#endif
+#if defined(AOSOA_LAYOUT) && !defined(MIXED_PRECISION)
+        if (inPlace) {
+            value_t* blk = aosoa_block(sv, bias);
+            apply_gate_group<LQS>(blk, blk + AOSOA_WIDTH, numGates, blockID, hostGates);
+            continue;
+        }
+#endif
+#ifdef AOSOA_LAYOUT
+        alignas(64) local_t local_buf[2 << LQS];
+        local_t* local_real = local_buf;
+        local_t* local_imag = local_buf + AOSOA_WIDTH;
+#else
+        alignas(64) local_t local_real[1 << LQS];
+        alignas(64) local_t local_imag[1 << LQS];
+#endif
+        fetch_data<LQS>(local_real, local_imag, sv, bias, relatedQubits);
+        // blocks are handed out to the threads in contiguous chunks
+        if (blockID + 1 < numBlocks) {
+#ifdef CPU_BIAS_TABLE
+            unsigned int next = blockBias != nullptr ? blockBias[blockID + 1] : block_bias(blockID + 1, blockHot);
+#else
+            unsigned int next = block_bias(blockID + 1, blockHot);
+#endif
+            prefetch_data<LQS>(sv, bias0 | next, relatedQubits);
+        }
+        apply_gate_group<LQS>(local_real, local_imag, numGates, blockID, hostGates);
+        save_data<LQS>(sv, local_real, local_imag, bias, relatedQubits, stream);
+    }
+}
+
+// svGroupBlock for a block size chosen at runtime, LQS counts down from MAX_BLOCK_QUBITS
+template<int LQS>
+struct SvGroupDispatch {
+    static void run(int blockQubits, cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, idx_t blockHot, unsigned int bias0, int numBlockBits, bool parallel, bool stream, const unsigned int* blockBias = nullptr) {
+        if (blockQubits == LQS) {
+            svGroupBlock<LQS>(sv, hostGates, numGates, relatedQubits, blockHot, bias0, 1 << (numBlockBits - LQS), parallel, stream, blockBias);
+        } else {
+            SvGroupDispatch<LQS - 1>::run(blockQubits, sv, hostGates, numGates, relatedQubits, blockHot, bias0, numBlockBits, parallel, stream, blockBias);
+        }
+    }
+};
+
+template<>
+struct SvGroupDispatch<MIN_BLOCK_QUBITS - 1> {
+    static void run(int blockQubits, cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, idx_t blockHot, unsigned int bias0, int numBlockBits, bool parallel, bool stream, const unsigned int* blockBias = nullptr) {
+        UNREACHABLE();
+    }
+};
+
+void svGroup(cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, int numLocalQubits, int blockQubits) {
+    idx_t blockHot = (idx_t(1) << numLocalQubits) - 1 - relatedQubits;
+    bool stream = use_stream_stores(sizeof(cpx) << numLocalQubits);
+    SvGroupDispatch<MAX_BLOCK_QUBITS>::run(blockQubits, sv, hostGates, numGates, relatedQubits, blockHot, 0, numLocalQubits, true, stream);
+}
+
+#ifdef CPU_BIAS_TABLE
+void svGroupTable(cpx* sv, KernelGate hostGates[], int numGates, idx_t relatedQubits, const unsigned int* blockBias, int numLocalQubits, int blockQubits) {
+    idx_t blockHot = (idx_t(1) << numLocalQubits) - 1 - relatedQubits;
+    bool stream = use_stream_stores(sizeof(cpx) << numLocalQubits);
+    SvGroupDispatch<MAX_BLOCK_QUBITS>::run(blockQubits, sv, hostGates, numGates, relatedQubits, blockHot, 0, numLocalQubits, true, stream, blockBias);
+}
+#endif
+
+// Two-level blocking: the state is cut into tiles over the qubits in tileQubits
+// (the union of the blocks of numGroups per-gate groups). Each thread takes a
+// tile and runs the blocks of every group that fall into it, so the tile is
+// read from memory by the first group and stays in L2 for the others. Block
+// ids count the non-related qubits of the tile only. Only the last group
+// writes with non-temporal stores.
+void svTiles(cpx* sv, int numGroups, KernelGate* hostGates[], const int numGates[], const idx_t relatedQubits[], idx_t tileQubits, int numLocalQubits, int blockQubits) {
+    int tileBits = bitCount(tileQubits);
+    idx_t tileHot = (idx_t(1) << numLocalQubits) - 1 - tileQubits;
+    bool stream = use_stream_stores(sizeof(cpx) << numLocalQubits);
+    #pragma omp parallel for
+    for (int tileID = 0; tileID < (1 << (numLocalQubits - tileBits)); tileID++) {
+        unsigned int tileBias = block_bias(tileID, tileHot);
+        for (int g = 0; g < numGroups; g++)
+            SvGroupDispatch<MAX_BLOCK_QUBITS>::run(blockQubits, sv, hostGates[g], numGates[g], relatedQubits[g], tileQubits - relatedQubits[g], tileBias, tileBits, false, stream && g == numGroups - 1);
+    }
+}
+
+#define BLAS_COLS 4
+// c = a * b, where a is a K * K column-major matrix and b, c are K * numCols
+// column-major matrices. Each thread keeps BLAS_COLS columns of c in registers
+// / L1 and streams the (L2-resident) split real / imag copy of a over them.
+void gemm(int K, idx_t numCols, const cpx* a, const cpx* b, cpx* c) {
+    std::vector<local_t> a_real(K * K), a_imag(K * K);
+    for (int i = 0; i < K * K; i++) {
+        a_real[i] = a[i].real();
+        a_imag[i] = a[i].imag();
+    }
+    #pragma omp parallel for
+    for (idx_t col = 0; col < numCols; col += BLAS_COLS) {
+        int cols = std::min(idx_t(BLAS_COLS), numCols - col);
+        local_t c_real[BLAS_COLS][K], c_imag[BLAS_COLS][K];
+        for (int j = 0; j < cols; j++)
+            for (int r = 0; r < K; r++) {
+                c_real[j][r] = 0;
+                c_imag[j][r] = 0;
+            }
+        const cpx* bc = b + col * K;
+        for (int k = 0; k < K; k++) {
+            const local_t* ar = a_real.data() + k * K;
+            const local_t* ai = a_imag.data() + k * K;
+            for (int j = 0; j < cols; j++) {
+                local_t br = bc[j * K + k].real(), bi = bc[j * K + k].imag();
+                #pragma omp simd
+                for (int r = 0; r < K; r++) {
+                    c_real[j][r] += ar[r] * br - ai[r] * bi;
+                    c_imag[j][r] += ar[r] * bi + ai[r] * br;
+                }
+            }
+        }
+        cpx* cc = c + col * K;
+        for (int j = 0; j < cols; j++)
+            for (int r = 0; r < K; r++)
+                cc[j * K + r] = cpx(c_real[j][r], c_imag[j][r]);
+    }
+}
+
+}
+}
@@ -0,0 +1,234 @@
+#pragma once
+// Thin wrappers over the vector intrinsics used by the group kernels, so that
+// one kernel body covers double (_pd) and float (_ps) local buffers on AVX-512 and AVX2.
+// Like kernel_sv.h this is compiled once per ISA into namespace
+// CpuImpl::KERNEL_ISA. USE_SIMD is defined when a vector ISA is enabled.
+//
+// vreg   VLEN values of local_t
+// vmask  per-lane select mask for vblend
+// vidx   VLEN 32-bit indices for vgather / vscatter (AVX-512 only)
+
+#include "cpu/kernel.h"
+#include <x86intrin.h>
+
+#if defined(USE_AVX512) || defined(USE_AVX2)
+#define USE_SIMD
+#endif
+
+namespace CpuImpl {
+namespace KERNEL_ISA {
+
+#if defined(USE_AVX512) && defined(LOCAL_DOUBLE)
+
+typedef __m512d vreg;
+typedef __mmask8 vmask;
+typedef __m256i vidx;
+constexpr int VLEN = 8;
+
+inline vreg vload(const local_t* p) { return _mm512_loadu_pd(p); }
+inline void vstore(local_t* p, vreg a) { _mm512_storeu_pd(p, a); }
+inline vreg vset1(local_t x) { return _mm512_set1_pd(x); }
+inline vreg vadd(vreg a, vreg b) { return _mm512_add_pd(a, b); }
+inline vreg vsub(vreg a, vreg b) { return _mm512_sub_pd(a, b); }
+inline vreg vmul(vreg a, vreg b) { return _mm512_mul_pd(a, b); }
+inline vreg vfmadd(vreg a, vreg b, vreg c) { return _mm512_fmadd_pd(a, b, c); } // a * b + c
+inline vreg vfnmadd(vreg a, vreg b, vreg c) { return _mm512_fnmadd_pd(a, b, c); } // c - a * b
+inline vmask vmask_from_bits(int bits) { return bits; }
+inline vreg vblend(vmask m, vreg a, vreg b) { return _mm512_mask_blend_pd(m, a, b); } // lane k: m[k] ? b : a
+
+inline vidx vidx_set1(int x) { return _mm256_set1_epi32(x); }
+inline vidx vidx_iota() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+inline vidx vidx_add(vidx a, vidx b) { return _mm256_add_epi32(a, b); }
+inline vidx vidx_and(vidx a, vidx b) { return _mm256_and_si256(a, b); }
+inline vidx vidx_or(vidx a, vidx b) { return _mm256_or_si256(a, b); }
+inline vreg vgather(vidx idx, const local_t* base) { return _mm512_i32gather_pd(idx, base, 8); }
+inline void vscatter(local_t* base, vidx idx, vreg a) { _mm512_i32scatter_pd(base, idx, a, 8); }
+
+// permutation over the 2 * VLEN lanes of (a, b), built from VLEN lane positions
+typedef __m512i vperm;
+// the maskz form, as the unmasked one merges into an undefined register (-Wuninitialized)
+inline vperm vperm_from(const int* pos) { return _mm512_maskz_cvtepi32_epi64(__mmask8(-1), _mm256_loadu_si256((const __m256i*) pos)); }
+inline vreg vpermute2(vreg a, vperm idx, vreg b) { return _mm512_permutex2var_pd(a, idx, b); }
+
+#elif defined(USE_AVX512)
+
+typedef __m512 vreg;
+typedef __mmask16 vmask;
+typedef __m512i vidx;
+constexpr int VLEN = 16;
+
+inline vreg vload(const local_t* p) { return _mm512_loadu_ps(p); }
+inline void vstore(local_t* p, vreg a) { _mm512_storeu_ps(p, a); }
+inline vreg vset1(local_t x) { return _mm512_set1_ps(x); }
+inline vreg vadd(vreg a, vreg b) { return _mm512_add_ps(a, b); }
+inline vreg vsub(vreg a, vreg b) { return _mm512_sub_ps(a, b); }
+inline vreg vmul(vreg a, vreg b) { return _mm512_mul_ps(a, b); }
+inline vreg vfmadd(vreg a, vreg b, vreg c) { return _mm512_fmadd_ps(a, b, c); }
+inline vreg vfnmadd(vreg a, vreg b, vreg c) { return _mm512_fnmadd_ps(a, b, c); }
+inline vmask vmask_from_bits(int bits) { return bits; }
+inline vreg vblend(vmask m, vreg a, vreg b) { return _mm512_mask_blend_ps(m, a, b); }
+
+inline vidx vidx_set1(int x) { return _mm512_set1_epi32(x); }
+inline vidx vidx_iota() { return _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); }
+inline vidx vidx_add(vidx a, vidx b) { return _mm512_add_epi32(a, b); }
+inline vidx vidx_and(vidx a, vidx b) { return _mm512_and_si512(a, b); }
+inline vidx vidx_or(vidx a, vidx b) { return _mm512_or_si512(a, b); }
+inline vreg vgather(vidx idx, const local_t* base) { return _mm512_i32gather_ps(idx, base, 4); }
+inline void vscatter(local_t* base, vidx idx, vreg a) { _mm512_i32scatter_ps(base, idx, a, 4); }
+
+typedef __m512i vperm;
+inline vperm vperm_from(const int* pos) { return _mm512_loadu_si512(pos); }
+inline vreg vpermute2(vreg a, vperm idx, vreg b) { return _mm512_permutex2var_ps(a, idx, b); }
+
+#elif defined(USE_AVX2) && defined(LOCAL_DOUBLE)
+
+typedef __m256d vreg;
+typedef __m256d vmask;
+constexpr int VLEN = 4;
+
+inline vreg vload(const local_t* p) { return _mm256_loadu_pd(p); }
+inline void vstore(local_t* p, vreg a) { _mm256_storeu_pd(p, a); }
+inline vreg vset1(local_t x) { return _mm256_set1_pd(x); }
+inline vreg vadd(vreg a, vreg b) { return _mm256_add_pd(a, b); }
+inline vreg vsub(vreg a, vreg b) { return _mm256_sub_pd(a, b); }
+inline vreg vmul(vreg a, vreg b) { return _mm256_mul_pd(a, b); }
+inline vreg vfmadd(vreg a, vreg b, vreg c) { return _mm256_fmadd_pd(a, b, c); }
+inline vreg vfnmadd(vreg a, vreg b, vreg c) { return _mm256_fnmadd_pd(a, b, c); }
+inline vmask vmask_from_bits(int bits) {
+    return _mm256_castsi256_pd(_mm256_setr_epi64x(-(bits & 1), -((bits >> 1) & 1), -((bits >> 2) & 1), -((bits >> 3) & 1)));
+}
+inline vreg vblend(vmask m, vreg a, vreg b) { return _mm256_blendv_pd(a, b, m); }
+
+#elif defined(USE_AVX2)
+
+typedef __m256 vreg;
+typedef __m256 vmask;
+constexpr int VLEN = 8;
+
+inline vreg vload(const local_t* p) { return _mm256_loadu_ps(p); }
+inline void vstore(local_t* p, vreg a) { _mm256_storeu_ps(p, a); }
+inline vreg vset1(local_t x) { return _mm256_set1_ps(x); }
+inline vreg vadd(vreg a, vreg b) { return _mm256_add_ps(a, b); }
+inline vreg vsub(vreg a, vreg b) { return _mm256_sub_ps(a, b); }
+inline vreg vmul(vreg a, vreg b) { return _mm256_mul_ps(a, b); }
+inline vreg vfmadd(vreg a, vreg b, vreg c) { return _mm256_fmadd_ps(a, b, c); }
+inline vreg vfnmadd(vreg a, vreg b, vreg c) { return _mm256_fnmadd_ps(a, b, c); }
+inline vmask vmask_from_bits(int bits) {
+    __m256i bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i sel = _mm256_and_si256(_mm256_set1_epi32(bits), bit);
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(sel, bit));
+}
+inline vreg vblend(vmask m, vreg a, vreg b) { return _mm256_blendv_ps(a, b, m); }
+
+#endif
+
+#ifdef USE_SIMD
+// Splits a window of 2 * VLEN consecutive amplitudes (v0, v1) into the lanes
+// whose bit targetQubit is clear (lo) and set (hi), for 1 << targetQubit < VLEN,
+// and merges them back. lanePos[k] is the window position of lo lane k.
+struct PairSplit {
+    int targetQubit;
+    int lanePos[VLEN];
+#ifdef USE_AVX512
+    vperm lo_idx, hi_idx, out0_idx, out1_idx;
+#elif !defined(LOCAL_DOUBLE)
+    __m256i lo_idx, hi_idx, out_idx;
+    vmask out_mask;
+#endif
+
+    PairSplit(int targetQubit): targetQubit(targetQubit) {
+        int low = (1 << targetQubit) - 1;
+        for (int k = 0; k < VLEN; k++)
+            lanePos[k] = ((k >> targetQubit) << (targetQubit + 1)) | (k & low);
+#ifdef USE_AVX512
+        // window element e goes back to lane k of lo (bit targetQubit clear) or hi (set)
+        int hi_pos[VLEN], out_pos[VLEN * 2];
+        for (int k = 0; k < VLEN; k++)
+            hi_pos[k] = lanePos[k] | (1 << targetQubit);
+        for (int e = 0; e < VLEN * 2; e++) {
+            int k = ((e >> (targetQubit + 1)) << targetQubit) | (e & low);
+            out_pos[e] = ((e >> targetQubit) & 1) ? VLEN + k : k;
+        }
+        lo_idx = vperm_from(lanePos);
+        hi_idx = vperm_from(hi_pos);
+        out0_idx = vperm_from(out_pos);
+        out1_idx = vperm_from(out_pos + VLEN);
+#elif defined(LOCAL_DOUBLE)
+        // unpacklo_pd gives lo lanes {0, 4, 2, 6} for target 0,
+        // permute2f128_pd gives {0, 1, 4, 5} for target 1
+        if (targetQubit == 0) {
+            const int pos[4] = {0, 4, 2, 6};
+            for (int k = 0; k < VLEN; k++) lanePos[k] = pos[k];
+        }
+#else
+        // each source vector holds 4 lo and 4 hi elements, gather them into
+        // lanes 0-3 of v0 and lanes 4-7 of v1 and blend the two halves
+        int lo_src[8], hi_src[8], out_src[8];
+        for (int k = 0; k < 4; k++) {
+            lo_src[k] = lo_src[k + 4] = lanePos[k];
+            hi_src[k] = hi_src[k + 4] = lanePos[k] | (1 << targetQubit);
+        }
+        int out_blend = 0;
+        for (int e = 0; e < 8; e++) {
+            out_src[e] = ((e >> (targetQubit + 1)) << targetQubit) | (e & low);
+            if ((e >> targetQubit) & 1) out_blend |= 1 << e;
+        }
+        out_mask = vmask_from_bits(out_blend);
+        lo_idx = _mm256_loadu_si256((const __m256i*) lo_src);
+        hi_idx = _mm256_loadu_si256((const __m256i*) hi_src);
+        out_idx = _mm256_loadu_si256((const __m256i*) out_src);
+#endif
+    }
+
+    void split(vreg v0, vreg v1, vreg& lo, vreg& hi) const {
+#ifdef USE_AVX512
+        lo = vpermute2(v0, lo_idx, v1);
+        hi = vpermute2(v0, hi_idx, v1);
+#elif defined(LOCAL_DOUBLE)
+        if (targetQubit == 0) {
+            lo = _mm256_unpacklo_pd(v0, v1);
+            hi = _mm256_unpackhi_pd(v0, v1);
+        } else {
+            lo = _mm256_permute2f128_pd(v0, v1, 0x20);
+            hi = _mm256_permute2f128_pd(v0, v1, 0x31);
+        }
+#else
+        lo = _mm256_blend_ps(_mm256_permutevar8x32_ps(v0, lo_idx), _mm256_permutevar8x32_ps(v1, lo_idx), 0xF0);
+        hi = _mm256_blend_ps(_mm256_permutevar8x32_ps(v0, hi_idx), _mm256_permutevar8x32_ps(v1, hi_idx), 0xF0);
+#endif
+    }
+
+    void merge(vreg lo, vreg hi, vreg& v0, vreg& v1) const {
+#ifdef USE_AVX512
+        v0 = vpermute2(lo, out0_idx, hi);
+        v1 = vpermute2(lo, out1_idx, hi);
+#elif defined(LOCAL_DOUBLE)
+        if (targetQubit == 0) {
+            v0 = _mm256_unpacklo_pd(lo, hi);
+            v1 = _mm256_unpackhi_pd(lo, hi);
+        } else {
+            v0 = _mm256_permute2f128_pd(lo, hi, 0x20);
+            v1 = _mm256_permute2f128_pd(lo, hi, 0x31);
+        }
+#else
+        // v1 takes the upper halves of lo and hi: swap the 128-bit lanes first
+        __m256 lo_up = _mm256_permute2f128_ps(lo, lo, 0x01), hi_up = _mm256_permute2f128_ps(hi, hi, 0x01);
+        v0 = _mm256_blendv_ps(_mm256_permutevar8x32_ps(lo, out_idx), _mm256_permutevar8x32_ps(hi, out_idx), out_mask);
+        v1 = _mm256_blendv_ps(_mm256_permutevar8x32_ps(lo_up, out_idx), _mm256_permutevar8x32_ps(hi_up, out_idx), out_mask);
+#endif
+    }
+};
+#endif
+
+// block id -> bias (the low bits of id deposited at the set bits of mask). The
+// vector variants are only picked on CPUs with BMI2, where this is one PDEP.
+inline unsigned int block_bias(unsigned int id, idx_t mask) {
+#ifdef USE_SIMD
+    return _pdep_u64(id, mask);
+#else
+    return spread_bits(id, mask);
+#endif
+}
+
+}
+}
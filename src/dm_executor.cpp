@@ -1,11 +1,15 @@
 #include "dm_executor.h"
 #include <assert.h>
 
+DMLowering::DMLowering(int numQubits, Schedule& schedule):
+    Lowering(numQubits, schedule) {}
+
 DMExecutor::DMExecutor(std::vector<cpx*> deviceStateVec, int numQubits, Schedule& schedule):
     Executor(deviceStateVec, numQubits, schedule) {}
 
 void DMExecutor::run() {
     // NOT MODIFIED
+    assert(schedule.lowered);
     for (size_t lgID = 0; lgID < schedule.localGroups.size(); lgID ++) {
         auto& localGroup = schedule.localGroups[lgID];
         if (lgID > 0) {
@@ -35,31 +39,34 @@ void DMExecutor::run() {
     this->finalize();
 }
 
-void DMExecutor::applyPerGateGroup(GateGroup& gg) {
+void DMLowering::lowerPerGateGroup(GateGroup& gg) {
     auto& gates = gg.gates;
     int numLocalQubits = numQubits - MyGlobalVars::bit / 2;
     idx_t relatedLogicQb = gg.relatedQubits;
     if (bitCount(relatedLogicQb) < LOCAL_QUBIT_SIZE) {
         relatedLogicQb = fillRelatedQubits(relatedLogicQb);
     }
-    idx_t relatedQubits = toPhyQubitSet(relatedLogicQb);
-    std::map<int, int> toID = getLogicShareMap(relatedQubits, numLocalQubits);
+    gg.phyRelatedQubits = toPhyQubitSet(relatedLogicQb);
+    std::map<int, int> toID = getLogicShareMap(gg.phyRelatedQubits, numLocalQubits);
 
-    KernelGate hostGates[MyGlobalVars::localGPUs * gates.size()];
     assert(gates.size() < MAX_GATE);
-    #pragma omp parallel for num_threads(MyGlobalVars::localGPUs)
+    gg.kernelGates.resize(MyGlobalVars::localGPUs * gates.size());
     for (int g = 0; g < MyGlobalVars::localGPUs; g++) {
         int globalGPUID = MyMPI::rank * MyGlobalVars::localGPUs + g;
         for (size_t i = 0; i < gates.size(); i++) {
-            hostGates[g * gates.size() + i] = getGate(gates[i], globalGPUID, numLocalQubits, relatedLogicQb, toID);
-            addError(&hostGates[g * gates.size() + i], gates[i]);
+            gg.kernelGates[g * gates.size() + i] = getGate(gates[i], globalGPUID, numLocalQubits, relatedLogicQb, toID);
+            addError(&gg.kernelGates[g * gates.size() + i], gates[i]);
         }
     }
-    launchPerGateGroupDM(gates, hostGates, state, relatedQubits, numLocalQubits);
+}
+
+void DMExecutor::applyPerGateGroup(GateGroup& gg) {
+    int numLocalQubits = numQubits - MyGlobalVars::bit / 2;
+    launchPerGateGroupDM(gg.gates, gg.kernelGates.data(), state, gg.phyRelatedQubits, numLocalQubits);
 }
 
 
-void DMExecutor::addError(KernelGate* gate, const Gate& g) {
+void DMLowering::addError(KernelGate* gate, const Gate& g) {
 #if MODE == 2
     gate->err_len_control = g.controlErrors.size();
     for (int i = 0; i < gate->err_len_control; i++) {
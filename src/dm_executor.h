@@ -1,12 +1,20 @@
 #pragma once
 #include "executor.h"
 
+// density matrix groups: kernel gates carry the error matrices of their gate
+class DMLowering: public Lowering {
+public:
+    DMLowering(int numQubits, Schedule& schedule);
+protected:
+    void lowerPerGateGroup(GateGroup& gg) override;
+    void addError(KernelGate* gate, const Gate& g);
+};
+
 class DMExecutor: public Executor {
 public:
     DMExecutor(std::vector<cpx*> deviceStateVec, int numQubits, Schedule& schedule);
     void run();
 protected:
     void applyPerGateGroup(GateGroup& gg) override;
-    void addError(KernelGate* gate, const Gate& g);
     virtual void launchPerGateGroupDM(std::vector<Gate>& gates, KernelGate hostGates[], const State& state, idx_t relatedQubits, int numLocalQubits) = 0;
 };
\ No newline at end of file
@@ -5,8 +5,9 @@
 #include <map>
 
 #include "schedule.h"
+#include "lowering.h"
 
-class Executor {
+class Executor: public Lowering {
 public:
     Executor(std::vector<cpx*> deviceStateVec, int numQubits, Schedule& schedule);
     void run();
@@ -26,10 +27,22 @@ protected:
     virtual void eventBarrier() = 0;
     virtual void eventBarrierAll() = 0;
     virtual void allBarrier() = 0;
+#ifdef LAZY_ACTIVATION
+    // zero the amplitudes [begin, end) of the local state
+    virtual void zeroAmps(idx_t begin, idx_t end) = 0;
+#endif
+
+    // multiply the state of each device by its accumulated phase
+    void flushGlobalPhase();
+#ifdef LAZY_ACTIVATION
+    // zero the local state up to 2^newActive amplitudes before a group runs on it
+    void growActive(int newActive);
+#endif
 
-    void setState(const State& newState) { state = newState; }
     void applyGateGroup(GateGroup& gg, int sliceID = -1);
     virtual void applyPerGateGroup(GateGroup& gg);
+    // numGroups consecutive per-gate groups marked as a super-group by the compiler
+    virtual void applySuperGroup(GateGroup* groups, int numGroups);
     void applyBlasGroup(GateGroup& gg);
     void applyPerGateGroupSliced(GateGroup& gg, int sliceID);
     void applyBlasGroupSliced(GateGroup& gg, int sliceID);
@@ -37,25 +50,14 @@ protected:
     void storeState();
     void loadState();
 
-    // utils
-    idx_t toPhyQubitSet(idx_t logicQubitset) const;
-    idx_t fillRelatedQubits(idx_t related) const;
-    KernelGate getGate(const Gate& gate, int part_id, int numLocalQubits, idx_t relatedLogicQb, const std::map<int, int>& toID) const;
-
-    // internal
-    std::map<int, int> getLogicShareMap(idx_t relatedQubits, int numLocalQubits) const; // input: physical, output logic -> share
-
-    State state;
     State oldState;
     std::vector<int> partID; // partID[slice][gpuID]
     std::vector<int> peer; // peer[slice][gpuID]
+    std::vector<cpx> globalPhase; // [gpuID] pending scale of the local state, applied before communication
+    int activeQubits; // running: amplitudes from 2^activeQubits on are not initialized yet
 
     // constants
     std::vector<cpx*> deviceStateVec;
     std::vector<cpx*> deviceBuffer;
-    int numQubits;
     int numSlice, numSliceBit;
-
-    //schedule
-    Schedule& schedule;
 };
\ No newline at end of file
@@ -3,12 +3,17 @@
 #include <cmath>
 #include <cstring>
 #include <assert.h>
+#include <atomic>
 
-static int globalGateID = 0;
+// factories may run on several threads (parallel parsing), so every thread
+// takes IDs from its own block of the global counter
+static std::atomic<int> globalGateID(0);
+static thread_local int localNextID = 0, localEndID = 0;
+const int GATE_ID_BLOCK = 1024;
 
 Gate Gate::CNOT(int controlQubit, int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::CNOT;
     g.mat[0][0] = cpx(0); g.mat[0][1] = cpx(1);
     g.mat[1][0] = cpx(1); g.mat[1][1] = cpx(0);
@@ -20,7 +25,7 @@ Gate Gate::CNOT(int controlQubit, int targetQubit) {
 
 Gate Gate::CY(int controlQubit, int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::CY;
     g.mat[0][0] = cpx(0); g.mat[0][1] = cpx(0, -1);
     g.mat[1][0] = cpx(0, 1); g.mat[1][1] = cpx(0);
@@ -32,7 +37,7 @@ Gate Gate::CY(int controlQubit, int targetQubit) {
 
 Gate Gate::CZ(int controlQubit, int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::CZ;
     g.mat[0][0] = cpx(1); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(-1);
@@ -44,7 +49,7 @@ Gate Gate::CZ(int controlQubit, int targetQubit) {
 
 Gate Gate::CRX(int controlQubit, int targetQubit, value_t angle) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::CRX;
     g.mat[0][0] = cpx(cos(angle/2.0)); g.mat[0][1] = cpx(0, -sin(angle/2.0));
     g.mat[1][0] = cpx(0, -sin(angle/2.0)); g.mat[1][1] = cpx(cos(angle/2.0));
@@ -56,7 +61,7 @@ Gate Gate::CRX(int controlQubit, int targetQubit, value_t angle) {
 
 Gate Gate::CRY(int controlQubit, int targetQubit, value_t angle) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::CRY;
     g.mat[0][0] = cpx(cos(angle/2.0)); g.mat[0][1] = cpx(-sin(angle/2.0));
     g.mat[1][0] = cpx(sin(angle/2.0)); g.mat[1][1] = cpx(cos(angle/2.0));
@@ -68,7 +73,7 @@ Gate Gate::CRY(int controlQubit, int targetQubit, value_t angle) {
 
 Gate Gate::CU1(int controlQubit, int targetQubit, value_t lambda) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::CU1;
     g.mat[0][0] = cpx(1);
     g.mat[0][1] = cpx(0);
@@ -82,7 +87,7 @@ Gate Gate::CU1(int controlQubit, int targetQubit, value_t lambda) {
 
 Gate Gate::CRZ(int controlQubit, int targetQubit, value_t angle) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::CRZ;
     g.mat[0][0] = cpx(cos(angle/2), -sin(angle/2)); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(cos(angle/2), sin(angle/2));
@@ -94,7 +99,7 @@ Gate Gate::CRZ(int controlQubit, int targetQubit, value_t angle) {
 
 Gate Gate::CU(int controlQubit, int targetQubit, std::vector<cpx> params) {
     Gate g;
-    g.gateID = ++globalGateID;
+    g.gateID = newID();
     g.type = GateType::CU;
     g.mat[0][0] = params[0]; g.mat[0][1] = params[1];
     g.mat[1][0] = params[2]; g.mat[1][1] = params[3];
@@ -106,7 +111,7 @@ Gate Gate::CU(int controlQubit, int targetQubit, std::vector<cpx> params) {
 
 Gate Gate::U1(int targetQubit, value_t lambda) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::U1;
     g.mat[0][0] = cpx(1);
     g.mat[0][1] = cpx(0);
@@ -120,7 +125,7 @@ Gate Gate::U1(int targetQubit, value_t lambda) {
 
 Gate Gate::U2(int targetQubit, value_t phi, value_t lambda) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::U2;
     g.mat[0][0] = cpx(1.0 / sqrt(2));
     g.mat[0][1] = cpx(-cos(lambda) / sqrt(2), -sin(lambda) / sqrt(2));
@@ -134,7 +139,7 @@ Gate Gate::U2(int targetQubit, value_t phi, value_t lambda) {
 
 Gate Gate::U3(int targetQubit, value_t theta, value_t phi, value_t lambda) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::U3;
     g.mat[0][0] = cpx(cos(theta / 2));
     g.mat[0][1] = cpx(-cos(lambda) * sin(theta / 2), -sin(lambda) * sin(theta / 2));
@@ -148,7 +153,7 @@ Gate Gate::U3(int targetQubit, value_t theta, value_t phi, value_t lambda) {
 
 Gate Gate::U(int targetQubit, std::vector<cpx> params) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::U;
     g.mat[0][0] = params[0]; g.mat[0][1] = params[1];
     g.mat[1][0] = params[2]; g.mat[1][1] = params[3];
@@ -160,7 +165,7 @@ Gate Gate::U(int targetQubit, std::vector<cpx> params) {
 
 Gate Gate::H(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::H;
     g.mat[0][0] = cpx(1/sqrt(2)); g.mat[0][1] = cpx(1/sqrt(2));
     g.mat[1][0] = cpx(1/sqrt(2)); g.mat[1][1] = cpx(-1/sqrt(2));
@@ -172,7 +177,7 @@ Gate Gate::H(int targetQubit) {
 
 Gate Gate::X(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::X;
     g.mat[0][0] = cpx(0); g.mat[0][1] = cpx(1);
     g.mat[1][0] = cpx(1); g.mat[1][1] = cpx(0);
@@ -184,7 +189,7 @@ Gate Gate::X(int targetQubit) {
 
 Gate Gate::Y(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::Y;
     g.mat[0][0] = cpx(0); g.mat[0][1] = cpx(0, -1);
     g.mat[1][0] = cpx(0, 1); g.mat[1][1] = cpx(0);
@@ -196,7 +201,7 @@ Gate Gate::Y(int targetQubit) {
 
 Gate Gate::Z(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::Z;
     g.mat[0][0] = cpx(1); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(-1);
@@ -208,7 +213,7 @@ Gate Gate::Z(int targetQubit) {
 
 Gate Gate::S(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::S;
     g.mat[0][0] = cpx(1); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(0, 1);
@@ -220,7 +225,7 @@ Gate Gate::S(int targetQubit) {
 
 Gate Gate::SDG(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::SDG;
     g.mat[0][0] = cpx(1); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(0, -1);
@@ -232,7 +237,7 @@ Gate Gate::SDG(int targetQubit) {
 
 Gate Gate::T(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::T;
     g.mat[0][0] = cpx(1); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(1/sqrt(2), 1/sqrt(2));
@@ -244,7 +249,7 @@ Gate Gate::T(int targetQubit) {
 
 Gate Gate::TDG(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::T;
     g.mat[0][0] = cpx(1); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(1/sqrt(2), -1/sqrt(2));
@@ -256,7 +261,7 @@ Gate Gate::TDG(int targetQubit) {
 
 Gate Gate::RX(int targetQubit, value_t angle) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::RX;
     g.mat[0][0] = cpx(cos(angle/2.0)); g.mat[0][1] = cpx(0, -sin(angle/2.0));
     g.mat[1][0] = cpx(0, -sin(angle/2.0)); g.mat[1][1] = cpx(cos(angle/2.0));
@@ -268,7 +273,7 @@ Gate Gate::RX(int targetQubit, value_t angle) {
 
 Gate Gate::RY(int targetQubit, value_t angle) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::RY;
     g.mat[0][0] = cpx(cos(angle/2.0)); g.mat[0][1] = cpx(-sin(angle/2.0));
     g.mat[1][0] = cpx(sin(angle/2.0)); g.mat[1][1] = cpx(cos(angle/2.0));
@@ -280,7 +285,7 @@ Gate Gate::RY(int targetQubit, value_t angle) {
 
 Gate Gate::RZ(int targetQubit, value_t angle) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::RZ;
     g.mat[0][0] = cpx(cos(angle/2), -sin(angle/2)); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(cos(angle/2), sin(angle/2));
@@ -292,7 +297,7 @@ Gate Gate::RZ(int targetQubit, value_t angle) {
 
 Gate Gate::ID(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::ID;
     g.mat[0][0] = cpx(1); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(1);
@@ -304,7 +309,7 @@ Gate Gate::ID(int targetQubit) {
 
 Gate Gate::GII(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::GII;
     g.mat[0][0] = cpx(0, 1); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(0, 1);
@@ -316,7 +321,7 @@ Gate Gate::GII(int targetQubit) {
 
 Gate Gate::GZZ(int targetQubit) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::GZZ;
     g.mat[0][0] = cpx(-1); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(-1);
@@ -328,7 +333,7 @@ Gate Gate::GZZ(int targetQubit) {
 
 Gate Gate::GOC(int targetQubit, value_t r, value_t i) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::GOC;
     g.mat[0][0] = cpx(1); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(r, i);
@@ -340,7 +345,7 @@ Gate Gate::GOC(int targetQubit, value_t r, value_t i) {
 
 Gate Gate::GCC(int targetQubit, value_t r, value_t i) {
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::GCC;
     g.mat[0][0] = cpx(r, i); g.mat[0][1] = cpx(0);
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(r, i);
@@ -356,7 +361,7 @@ Gate Gate::RZZ(int targetQubit1, int targetQubit2, value_t theta) {
     //  0    0   [01]  0
     //  0    0    0   [00]
     Gate g;
-    g.gateID = ++ globalGateID;
+    g.gateID = newID();
     g.type = GateType::RZZ;
     g.mat[0][0] = cpx(cos(theta/2), -sin(theta/2)); g.mat[0][1] = cpx(cos(theta/2), sin(theta/2));
     g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(0);
@@ -367,12 +372,43 @@ Gate Gate::RZZ(int targetQubit1, int targetQubit2, value_t theta) {
     return g;
 }
 
+Gate Gate::SWAP(int targetQubit1, int targetQubit2) {
+    Gate g;
+    g.gateID = newID();
+    g.type = GateType::SWAP;
+    g.mat[0][0] = cpx(1); g.mat[0][1] = cpx(0);
+    g.mat[1][0] = cpx(0); g.mat[1][1] = cpx(1);
+    g.name = "SWAP";
+    g.encodeQubit = targetQubit1;
+    g.targetQubit = targetQubit2;
+    g.controlQubit = -3;
+    return g;
+}
+
+std::vector<Gate> Gate::permutation(const std::vector<int>& perm) {
+    int n = perm.size();
+    std::vector<int> holder(n), at(n); // holder[q]: whose state is on q, at[i]: where the state of i is
+    for (int i = 0; i < n; i++) {
+        holder[i] = i;
+        at[i] = i;
+    }
+    std::vector<Gate> ret;
+    for (int i = 0; i < n; i++) {
+        int q = perm[i], p = at[i];
+        if (p == q) continue;
+        ret.push_back(Gate::SWAP(p, q));
+        int other = holder[q];
+        holder[p] = other; at[other] = p;
+        holder[q] = i; at[i] = q;
+    }
+    return ret;
+}
+
 Gate Gate::MCU(std::vector<int> controlQubits, int targetQubit, std::vector<cpx> params) {
-    printf("[warning] MCU gate is not tested!\n");
     if (controlQubits.size() == 0) return Gate::U(targetQubit, params);
     if (controlQubits.size() == 1) return Gate::CU(controlQubits[0], targetQubit, params);
     Gate g;
-    g.gateID = ++globalGateID;
+    g.gateID = newID();
     g.type = GateType::MCU;
     g.mat[0][0] = params[0]; g.mat[0][1] = params[1];
     g.mat[1][0] = params[2]; g.mat[1][1] = params[3];
@@ -386,7 +422,7 @@ Gate Gate::MCU(std::vector<int> controlQubits, int targetQubit, std::vector<cpx>
 
 Gate Gate::V01(int targetQubit, cpx val) {
     Gate g;
-    g.gateID = ++globalGateID;
+    g.gateID = newID();
     g.type = GateType::V01;
     g.mat[0][0] = cpx(0.0); g.mat[0][1] = val;
     g.mat[1][0] = cpx(0.0); g.mat[1][1] = cpx(0.0);
@@ -397,7 +433,7 @@ Gate Gate::V01(int targetQubit, cpx val) {
 
 Gate Gate::DIG(int targetQubit, cpx lo, cpx hi) {
     Gate g;
-    g.gateID = ++globalGateID;
+    g.gateID = newID();
     g.type = GateType::DIG;
     g.mat[0][0] = lo; g.mat[0][1] = cpx(0.0);
     g.mat[1][0] = cpx(0.0); g.mat[1][1] = hi;
@@ -407,7 +443,15 @@ Gate Gate::DIG(int targetQubit, cpx lo, cpx hi) {
 }
 
 int Gate::newID() {
-    return ++globalGateID;
+    if (localNextID == localEndID) {
+        localNextID = globalGateID.fetch_add(GATE_ID_BLOCK) + 1;
+        localEndID = localNextID + GATE_ID_BLOCK;
+    }
+    return localNextID++;
+}
+
+int Gate::reserveIDs(int num) {
+    return globalGateID.fetch_add(num) + 1;
 }
 
 auto gen_01_float = []() {
@@ -658,55 +702,7 @@ std::string Gate::get_name(GateType ty) {
         case GateType::DIG: return "DIG";
         case GateType::MCI: return "MCI";
         case GateType::V01: return "V01";
+        case GateType::SWAP: return "SWAP";
     }
     UNREACHABLE();
 }
-
-std::vector<unsigned char> Gate::serialize() const {
-    auto name_len = name.length();
-    auto cerr_len = controlErrors.size();
-    auto terr_len = targetErrors.size();
-    int len =
-        sizeof(name_len) + name.length() + 1 + sizeof(gateID) + sizeof(type) + sizeof(mat)
-        + sizeof(targetQubit) + sizeof(controlQubit) + sizeof(encodeQubit)
-        + sizeof(cerr_len) + sizeof(Error) * cerr_len + sizeof(terr_len) + sizeof(Error) * terr_len;
-    std::vector<unsigned char> ret; ret.resize(len);
-    unsigned char* arr = ret.data();
-    int cur = 0;
-    SERIALIZE_STEP(gateID);
-    SERIALIZE_STEP(type);
-    memcpy(arr + cur, mat, sizeof(mat)); cur += sizeof(cpx) * 4;
-    SERIALIZE_STEP(name_len);
-    strcpy(reinterpret_cast<char*>(arr) + cur, name.c_str()); cur += name_len + 1;
-    SERIALIZE_STEP(targetQubit);
-    SERIALIZE_STEP(controlQubit);
-    SERIALIZE_STEP(encodeQubit);
-    SERIALIZE_STEP(cerr_len);
-    if (cerr_len > 0)
-        memcpy(arr + cur, controlErrors.data(), sizeof(Error) * cerr_len);
-    cur += sizeof(Error) * cerr_len;
-    SERIALIZE_STEP(terr_len);
-    if (terr_len > 0)
-        memcpy(arr + cur, targetErrors.data(), sizeof(Error) * terr_len);
-    cur += sizeof(Error) * terr_len;
-    assert(cur == len);
-    return ret;
-}
-
-Gate Gate::deserialize(const unsigned char* arr, int& cur) {
-    Gate g;
-    DESERIALIZE_STEP(g.gateID);
-    DESERIALIZE_STEP(g.type);
-    memcpy(g.mat, arr + cur, sizeof(g.mat)); cur += sizeof(cpx) * 4;
-    decltype(g.name.length()) name_len; DESERIALIZE_STEP(name_len);
-    g.name = std::string(reinterpret_cast<const char*>(arr) + cur, name_len); cur += name_len + 1;
-    DESERIALIZE_STEP(g.targetQubit);
-    DESERIALIZE_STEP(g.controlQubit);
-    DESERIALIZE_STEP(g.encodeQubit);
-    decltype(g.controlErrors.size()) cerr_len, terr_len;
-    DESERIALIZE_STEP(cerr_len);
-    DESERIALIZE_VECTOR(g.controlErrors, cerr_len);
-    DESERIALIZE_STEP(terr_len);
-    DESERIALIZE_VECTOR(g.targetErrors, terr_len);
-    return g;
-}
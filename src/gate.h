@@ -5,7 +5,7 @@
 #include "utils.h"
 
 enum class GateType {
-    CNOT, CY, CZ, CRX, CRY, CU1, CRZ, CU, U1, U2, U3, U, H, X, Y, Z, S, SDG, T, TDG, RX, RY, RZ, RZZ, MCU, TOTAL, ID, GII, GZZ, GOC, GCC, DIG, MCI, V01
+    CNOT, CY, CZ, CRX, CRY, CU1, CRZ, CU, U1, U2, U3, U, H, X, Y, Z, S, SDG, T, TDG, RX, RY, RZ, RZZ, MCU, TOTAL, ID, GII, GZZ, GOC, GCC, DIG, MCI, V01, SWAP
 };
 
 struct Error {
@@ -47,6 +47,14 @@ struct Gate {
     bool isDiagonal() const {
         return type == GateType::CZ || type == GateType::CU1 || type == GateType::CRZ || type == GateType::U1 || type == GateType::Z || type == GateType::S || type == GateType::SDG || type == GateType::T || type == GateType::TDG || type == GateType::RZ || type == GateType::RZZ || type == GateType::DIG;
     }
+#endif
+#ifdef PAULI_FRAME
+    // X / Y on a global qubit only flip the Pauli frame of the executor
+    bool isFramePauli() const {
+        return (type == GateType::X || type == GateType::Y) && isSingleGate();
+    }
+#else
+    bool isFramePauli() const { return false; }
 #endif
     bool hasControl(int q) const {
         if (isControlGate()) return controlQubit == q;
@@ -89,15 +97,18 @@ struct Gate {
     static Gate DIG(int targetQubit, cpx lo, cpx hi);
     static Gate V01(int targetQubit, cpx val);
     static Gate RZZ(int targetQubit1, int targetQubit2, value_t angle);
+    // never executed: Compiler::absorbSwaps relabels the qubits of the gates after it
+    static Gate SWAP(int targetQubit1, int targetQubit2);
+    // SWAPs that move the state of qubit i to qubit perm[i]
+    static std::vector<Gate> permutation(const std::vector<int>& perm);
     static Gate MCU(std::vector<int> controlQubits, int targetQubit, std::vector<cpx> params);
     static int newID();
+    static int reserveIDs(int num); // returns the first of num consecutive IDs
     static Gate random(int lo, int hi);
     static Gate random(int lo, int hi, GateType type);
     static Gate control(int controlQubit, int targetQubit, GateType type);
     static GateType toU(GateType type);
     static std::string get_name(GateType ty);
-    std::vector<unsigned char> serialize() const;
-    static Gate deserialize(const unsigned char* arr, int& cur);
 };
 
 struct KernelGate {
@@ -0,0 +1,451 @@
+#include "lowering.h"
+
+#include <algorithm>
+
+#include "utils.h"
+#include "assert.h"
+
+Lowering::Lowering(int numQubits, Schedule& schedule):
+    numQubits(numQubits),
+    schedule(schedule) {
+    pauliFrame = 0;
+    activeLogicQb = 0;
+}
+
+// Walks the schedule with the same state transitions as run(). The overlap
+// groups depend on the partID of the slice and are still lowered when applied.
+void Lowering::lower() {
+    pauliFrame = 0;
+    activeLogicQb = 0;
+    int numLocalQubits = numQubits - MyGlobalVars::bit;
+    for (size_t lgID = 0; lgID < schedule.localGroups.size(); lgID++) {
+        auto& localGroup = schedule.localGroups[lgID];
+        this->setState(localGroup.state);
+        this->resolvePauliFrame(localGroup);
+#ifdef ENABLE_OVERLAP
+        for (auto& gg: localGroup.overlapGroups)
+            this->setState(gg.state);
+#endif
+        auto& fullGroups = localGroup.fullGroups;
+        for (size_t i = 0; i < fullGroups.size(); i += fullGroups[i].superGroup) {
+            int active = numLocalQubits;
+#ifdef LAZY_ACTIVATION
+            // the communication moves the whole local state
+            if (lgID == 0)
+                active = activePrefix(fullGroups.data() + i, fullGroups[i].superGroup);
+#endif
+            for (int j = 0; j < fullGroups[i].superGroup; j++)
+                fullGroups[i + j].activeQubits = active;
+            if (fullGroups[i].superGroup > 1) {
+                this->lowerSuperGroup(fullGroups.data() + i, fullGroups[i].superGroup);
+            } else {
+                if (fullGroups[i].backend == Backend::PerGate)
+                    this->lowerPerGateGroup(fullGroups[i]);
+                this->setState(fullGroups[i].state);
+            }
+        }
+    }
+    // the rest of the frame is resolved when the amplitudes are read (Circuit::toLogicID)
+    schedule.pauliFrame = schedule.circuitQubitSet(pauliFrame);
+    schedule.lowered = true;
+}
+
+void Lowering::lowerPerGateGroup(GateGroup& gg) {
+    auto& gates = gg.gates;
+    // local qubits from position activeQubits on are lowered as global qubits of value 0
+    int numLocalQubits = gg.activeQubits;
+    int inactive = numQubits - MyGlobalVars::bit - numLocalQubits;
+    // initialize blockHot, enumerate, threadBias
+    idx_t relatedLogicQb = gg.relatedQubits;
+    if (bitCount(relatedLogicQb) < MyGlobalVars::blockQubits) {
+        relatedLogicQb = fillRelatedQubits(relatedLogicQb);
+    }
+    gg.phyRelatedQubits = toPhyQubitSet(relatedLogicQb);
+
+    // initialize gates
+    std::map<int, int> toID = getLogicShareMap(gg.phyRelatedQubits, numLocalQubits);
+
+    assert(gates.size() < MAX_GATE);
+    gg.kernelGates.resize(MyGlobalVars::localGPUs * gates.size());
+    for (size_t i = 0; i < gates.size(); i++) {
+        for (int g = 0; g < MyGlobalVars::localGPUs; g++) {
+            int globalGPUID = MyMPI::rank * MyGlobalVars::localGPUs + g;
+            gg.kernelGates[g * gates.size() + i] = getGate(gates[i], idx_t(globalGPUID) << inactive, numLocalQubits, relatedLogicQb, toID);
+        }
+        trackPauliFrame(gates[i]);
+    }
+    foldGlobalPhase(gg);
+}
+
+void Lowering::trackPauliFrame(const Gate& gate) {
+    if (gate.isFramePauli() && state.pos[gate.targetQubit] >= numQubits - MyGlobalVars::bit)
+        pauliFrame ^= idx_t(1) << gate.targetQubit;
+}
+
+// The kernels index local qubits by position, so a frame bit cannot outlive the
+// communication that makes its qubit local: it is applied as an X right after it.
+void Lowering::resolvePauliFrame(LocalGroup& lg) {
+    lg.frameGroups.clear();
+    int numLocalQubits = numQubits - MyGlobalVars::bit;
+    for (int i = 0; i < numLocalQubits; i++) {
+        int q = state.layout[i];
+        if (!(pauliFrame >> q & 1))
+            continue;
+        if (lg.frameGroups.empty() || bitCount(lg.frameGroups.back().relatedQubits) == MyGlobalVars::blockQubits) {
+            lg.frameGroups.emplace_back();
+            lg.frameGroups.back().backend = Backend::PerGate;
+            lg.frameGroups.back().state = state;
+            lg.frameGroups.back().activeQubits = numLocalQubits;
+        }
+        lg.frameGroups.back().addGate(Gate::X(q), -1ll, true);
+        pauliFrame ^= idx_t(1) << q;
+    }
+    for (auto& gg: lg.frameGroups)
+        lowerPerGateGroup(gg);
+}
+
+#ifdef LAZY_ACTIVATION
+// Every qubit starts in |0>, and stays there until a non-diagonal gate targets
+// it (a related qubit of its group). Up to that point, all nonzero amplitudes
+// have a 0 at its position. The local positions of the qubits activated so far
+// (at least a block) thus bound the part of the local state a group works on.
+int Lowering::activePrefix(const GateGroup* groups, int numGroups) {
+    for (int i = 0; i < numGroups; i++)
+        activeLogicQb |= groups[i].relatedQubits;
+    int numLocalQubits = numQubits - MyGlobalVars::bit;
+    int active = std::min(MyGlobalVars::blockQubits, numLocalQubits);
+    for (int i = active; i < numLocalQubits; i++)
+        if (activeLogicQb >> state.layout[i] & 1)
+            active = i + 1;
+    return active;
+}
+#endif
+
+// GCC / GZZ / GII come from diagonal gates on global qubits and multiply the
+// whole local state by a constant. They are replaced by ID and their product
+// is applied once per communication step instead of once per group.
+void Lowering::foldGlobalPhase(GateGroup& gg) {
+    int numGates = gg.kernelGates.size() / MyGlobalVars::localGPUs;
+    gg.globalPhase.assign(MyGlobalVars::localGPUs, cpx(1));
+    bool onlyID = true;
+    for (int g = 0; g < MyGlobalVars::localGPUs; g++) {
+        for (int i = 0; i < numGates; i++) {
+            auto& gate = gg.kernelGates[g * numGates + i];
+            if (gate.type == GateType::GCC || gate.type == GateType::GZZ || gate.type == GateType::GII) {
+                gg.globalPhase[g] *= cpx(gate.r00, gate.i00);
+                gate = KernelGate::ID();
+            }
+            onlyID &= gate.type == GateType::ID;
+        }
+    }
+    if (onlyID)
+        gg.kernelGates.clear();
+}
+
+void Lowering::lowerSuperGroup(GateGroup* groups, int numGroups) {
+    for (int i = 0; i < numGroups; i++) {
+        lowerPerGateGroup(groups[i]);
+        setState(groups[i].state);
+    }
+}
+
+#define SET_GATE_TO_ID(g, i) { \
+    cpx mat[2][2] = {1, 0, 0, 1}; \
+    hostGates[g * gates.size() + i] = KernelGate(GateType::ID, 0, 0, mat); \
+}
+
+#define IS_SHARE_QUBIT(logicIdx) ((relatedLogicQb >> logicIdx & 1) > 0)
+#define IS_LOCAL_QUBIT(logicIdx) (state.pos[logicIdx] < numLocalQubits)
+#define IS_HIGH_PART(part_id, logicIdx) ((((part_id >> (state.pos[logicIdx] - numLocalQubits)) ^ (pauliFrame >> logicIdx)) & 1) > 0)
+
+KernelGate Lowering::getGate(const Gate& gate, idx_t part_id, int numLocalQubits, idx_t relatedLogicQb, const std::map<int, int>& toID) const {
+    if (gate.isMCGate()) {
+        idx_t cbits = 0;
+        for (auto q: gate.controlQubits) {
+            if (!IS_LOCAL_QUBIT(q)) {
+                if (!IS_HIGH_PART(part_id, q)) {
+                    return KernelGate::ID();
+                }
+            } else {
+                if (IS_SHARE_QUBIT(q)) {
+                    cbits |= 1ll << toID.at(q);
+                } else {
+                    cbits |= 1ll << (toID.at(q) + MyGlobalVars::blockQubits);
+                }
+            }
+        }
+        int t = gate.targetQubit;
+        if (IS_LOCAL_QUBIT(t)) {
+            return KernelGate::mcGate(
+                gate.type, cbits,
+                toID.at(t), 1 - IS_SHARE_QUBIT(t),
+                gate.mat
+            );
+        } else {
+            cpx val = IS_HIGH_PART(part_id, t) ? gate.mat[1][1]: gate.mat[0][0];
+            cpx mat[2][2] = {val, cpx(0), cpx(0), val};
+            return KernelGate::mcGate(GateType::MCI, cbits, 0, 0, mat);
+        }
+    } else if (gate.isTwoQubitGate()) {
+        int t1 = gate.encodeQubit, t2 = gate.targetQubit;
+        if (IS_LOCAL_QUBIT(t1) && IS_LOCAL_QUBIT(t2)) {
+            return KernelGate::twoQubitGate(
+                gate.type,
+                toID.at(gate.encodeQubit), 1 - IS_SHARE_QUBIT(gate.encodeQubit),
+                toID.at(gate.targetQubit), 1 - IS_SHARE_QUBIT(gate.targetQubit),
+                gate.mat
+            );
+        } else if (IS_LOCAL_QUBIT(t1) && !IS_LOCAL_QUBIT(t2)) {
+            if (!IS_HIGH_PART(part_id, t2)) {
+                cpx mat[2][2] = {{gate.mat[0][0], cpx(0.0)}, {cpx(0.0), gate.mat[0][1]}};
+                return KernelGate::singleQubitGate(
+                    GateType::DIG,
+                    toID.at(t1), 1 - IS_SHARE_QUBIT(t1),
+                    mat
+                );
+            } else {
+                cpx mat[2][2] = {{gate.mat[0][1], cpx(0.0)}, {cpx(0.0), gate.mat[0][0]}};
+                return KernelGate::singleQubitGate(
+                    GateType::DIG,
+                    toID.at(t1), 1 - IS_SHARE_QUBIT(t1),
+                    mat
+                );
+            }
+        } else if (!IS_LOCAL_QUBIT(t1) && IS_LOCAL_QUBIT(t2)) {
+            if (!IS_HIGH_PART(part_id, t1)) {
+                cpx mat[2][2] = {{gate.mat[0][0], cpx(0.0)}, {cpx(0.0), gate.mat[0][1]}};
+                return KernelGate::singleQubitGate(
+                    GateType::DIG,
+                    toID.at(t2), 1 - IS_SHARE_QUBIT(t2),
+                    mat
+                );
+            } else {
+                cpx mat[2][2] = {{gate.mat[0][1], cpx(0.0)}, {cpx(0.0), gate.mat[0][0]}};
+                return KernelGate::singleQubitGate(
+                    GateType::DIG,
+                    toID.at(t2), 1 - IS_SHARE_QUBIT(t2),
+                    mat
+                );
+            }
+        } else { // !IS_LOCAL_QUBIT(t1) && !IS_LOCAL_QUBIT(t2)
+            cpx val = IS_HIGH_PART(part_id, t1) == IS_HIGH_PART(part_id, t2) ? gate.mat[0][0] : gate.mat[0][1];
+            cpx mat[2][2] = {{val, cpx(0.0)}, {cpx(0.0), val}};
+            return KernelGate::singleQubitGate(GateType::GCC, 0, 0, mat);
+        }
+    } else if (gate.isControlGate()) {
+        int c = gate.controlQubit, t = gate.targetQubit;
+        if (IS_LOCAL_QUBIT(c) && IS_LOCAL_QUBIT(t)) { // CU(c, t)
+            return KernelGate::controlledGate(
+                gate.type,
+                toID.at(c), 1 - IS_SHARE_QUBIT(c),
+                toID.at(t), 1 - IS_SHARE_QUBIT(t),
+                gate.mat
+            );
+        } else if (IS_LOCAL_QUBIT(c) && !IS_LOCAL_QUBIT(t)) { // U(c)
+            switch (gate.type) {
+                case GateType::CZ: {
+                    if (IS_HIGH_PART(part_id, t)) {
+                        return KernelGate::singleQubitGate(
+                            GateType::Z,
+                            toID.at(c), 1 - IS_SHARE_QUBIT(c),
+                            gate.mat
+                        );
+                    } else {
+                        return KernelGate::ID();
+                    }
+                }
+                case GateType::CU1: {
+                    if (IS_HIGH_PART(part_id, t)) {
+                        return KernelGate::singleQubitGate(
+                            GateType::U1,
+                            toID.at(c), 1 - IS_SHARE_QUBIT(c),
+                            gate.mat
+                        );
+                    } else {
+                        return KernelGate::ID();
+                    }
+                }
+                case GateType::CRZ: { // GOC(c)
+                    cpx mat[2][2] = {cpx(1), cpx(0), cpx(0), IS_HIGH_PART(part_id, t) ? gate.mat[1][1]: gate.mat[0][0]};
+                    return KernelGate::singleQubitGate(
+                        GateType::GOC,
+                        toID.at(c), 1 - IS_SHARE_QUBIT(c),
+                        mat
+                    );
+                }
+                default: {
+                    UNREACHABLE()
+                }
+            }
+        } else if (!IS_LOCAL_QUBIT(c) && IS_LOCAL_QUBIT(t)) {
+            if (IS_HIGH_PART(part_id, c)) { // U(t)
+                return KernelGate::singleQubitGate(
+                    Gate::toU(gate.type),
+                    toID.at(t), 1 - IS_SHARE_QUBIT(t),
+                    gate.mat
+                );
+            } else {
+                return KernelGate::ID();
+            }
+        } else { // !IS_LOCAL_QUBIT(c) && !IS_LOCAL_QUBIT(t)
+            assert(gate.isDiagonal());
+            if (IS_HIGH_PART(part_id, c)) {
+                switch (gate.type) {
+                    case GateType::CZ: {
+                        if (IS_HIGH_PART(part_id, t)) {
+                            cpx mat[2][2] = {cpx(-1), cpx(0), cpx(0), cpx(-1)};
+                            return KernelGate::singleQubitGate(
+                                GateType::GZZ,
+                                0, 0,
+                                mat
+                            );
+                        } else {
+                            return KernelGate::ID();
+                        }
+                    }
+                    case GateType::CU1: {
+                        if (IS_HIGH_PART(part_id, t)) {
+                            cpx mat[2][2] = {gate.mat[1][1], cpx(0), cpx(0), gate.mat[1][1]};
+                            return KernelGate::singleQubitGate(
+                                GateType::GCC,
+                                0, 0,
+                                mat
+                            );
+                        }
+                    }
+                    case GateType::CRZ: {
+                        cpx val = IS_HIGH_PART(part_id, t) ? gate.mat[1][1]: gate.mat[0][0];
+                        cpx mat[2][2] = {val, cpx(0), cpx(0), val};
+                        return KernelGate::singleQubitGate(
+                            GateType::GCC,
+                            0, 0,
+                            mat
+                        );
+                    }
+                    default: {
+                        UNREACHABLE()
+                    }
+                }
+            } else {
+                return KernelGate::ID();
+            }
+        }
+    } else {
+        int t = gate.targetQubit;
+        if (!IS_LOCAL_QUBIT(t)) { // GCC(t)
+            switch (gate.type) {
+                case GateType::U1: {
+                    if (IS_HIGH_PART(part_id, t)) {
+                        cpx val = gate.mat[1][1];
+                        cpx mat[2][2] = {val, cpx(0), cpx(0), val};
+                        return KernelGate::singleQubitGate(GateType::GCC, 0, 0, mat);
+                    } else {
+                        return KernelGate::ID();
+                    }
+                }
+                case GateType::Z: {
+                    if (IS_HIGH_PART(part_id, t)) {
+                        cpx mat[2][2] = {cpx(-1), cpx(0), cpx(0), cpx(-1)};
+                        return KernelGate::singleQubitGate(GateType::GZZ, 0, 0, mat);
+                    } else {
+                        return KernelGate::ID();
+                    }
+                }
+                case GateType::S: {
+                    if (IS_HIGH_PART(part_id, t)) {
+                        cpx val = cpx(0, 1);
+                        cpx mat[2][2] = {val, cpx(0), cpx(0), val};
+                        return KernelGate::singleQubitGate(GateType::GII, 0, 0, mat);
+                    } else {
+                        return KernelGate::ID();
+                    }
+                }
+                case GateType::SDG: {
+                    // FIXME
+                    if (IS_HIGH_PART(part_id, t)) {
+                        cpx val = cpx(0, -1);
+                        cpx mat[2][2] = {val, cpx(0), cpx(0), val};
+                        return KernelGate::singleQubitGate(GateType::GCC, 0, 0, mat);
+                    } else {
+                        return KernelGate::ID();
+                    }
+                }
+                case GateType::T: {
+                    if (IS_HIGH_PART(part_id, t)) {
+                        cpx val = gate.mat[1][1];
+                        cpx mat[2][2] = {val, cpx(0), cpx(0), val};
+                        return KernelGate::singleQubitGate(GateType::GCC, 0, 0, mat);
+                    } else {
+                        return KernelGate::ID();
+                    }
+                }
+                case GateType::TDG: {
+                    if (IS_HIGH_PART(part_id, t)) {
+                        cpx val = gate.mat[1][1];
+                        cpx mat[2][2] = {val, cpx(0), cpx(0), val};
+                        return KernelGate::singleQubitGate(GateType::GCC, 0, 0, mat);
+                    } else {
+                        return KernelGate::ID();
+                    }
+                }
+                case GateType::RZ: {
+                    cpx val = IS_HIGH_PART(part_id, t) ? gate.mat[1][1]: gate.mat[0][0];
+                    cpx mat[2][2] = {val, cpx(0), cpx(0), val};
+                    return KernelGate::singleQubitGate(GateType::GCC, 0, 0, mat);
+                }
+                case GateType::ID: {
+                    return KernelGate::ID();
+                }
+#ifdef PAULI_FRAME
+                case GateType::X: // no break
+                case GateType::Y: { // the caller flips the frame of t (trackPauliFrame)
+                    cpx val = IS_HIGH_PART(part_id, t) ? gate.mat[0][1] : gate.mat[1][0];
+                    cpx mat[2][2] = {val, cpx(0), cpx(0), val};
+                    return KernelGate::singleQubitGate(GateType::GCC, 0, 0, mat);
+                }
+#endif
+                default: {
+                    UNREACHABLE()
+                }
+            }
+        } else { // IS_LOCAL_QUBIT(t) -> U(t)
+            return KernelGate::singleQubitGate(gate.type, toID.at(t), 1 - IS_SHARE_QUBIT(t), gate.mat);
+        }
+    }
+}
+
+idx_t Lowering::toPhyQubitSet(idx_t logicQubitset) const {
+     idx_t ret = 0;
+    for (int i = 0; i < numQubits; i++)
+        if (logicQubitset >> i & 1)
+            ret |= idx_t(1) << state.pos[i];
+    return ret;
+}
+
+idx_t Lowering::fillRelatedQubits(idx_t relatedLogicQb) const {
+    return state.fillRelated(relatedLogicQb, MyGlobalVars::blockQubits);
+}
+
+std::map<int, int> Lowering::getLogicShareMap(idx_t relatedQubits, int numLocalQubits, idx_t tileQubits) const{
+    int shareCnt = 0;
+    int localCnt = 0;
+    int globalCnt = 0;
+    std::map<int, int> toID;
+#if GPU_BACKEND==2
+    for (int i = 0; i < numLocalQubits; i++)
+        toID[state.layout[i]] = localCnt++;
+    for (int i = numLocalQubits; i < numQubits; i++)
+        toID[state.layout[i]] = globalCnt++;
+#else
+    for (int i = 0; i < numLocalQubits; i++) {
+        if (relatedQubits & (idx_t(1) << i)) {
+            toID[state.layout[i]] = shareCnt++;
+        } else if (tileQubits & (idx_t(1) << i)) {
+            toID[state.layout[i]] = localCnt++;
+        }
+    }
+    for (int i = numLocalQubits; i < numQubits; i++)
+        toID[state.layout[i]] = globalCnt++;
+#endif
+    return toID;
+}
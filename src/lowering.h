@@ -0,0 +1,54 @@
+#pragma once
+#include "utils.h"
+
+#include <vector>
+#include <map>
+
+#include "schedule.h"
+
+// Turns the gates of the schedule into the kernel gates of this rank. It needs
+// no state vector, so Circuit::compile runs it once on the schedule; the
+// executors reuse the gate lowering for the overlap groups, whose part id
+// depends on the slice.
+class Lowering {
+public:
+    Lowering(int numQubits, Schedule& schedule);
+    virtual ~Lowering() = default;
+    // precompute the kernel gates and physical related qubits of every per-gate group of this rank
+    void lower();
+
+protected:
+    virtual void lowerPerGateGroup(GateGroup& gg);
+    virtual void lowerSuperGroup(GateGroup* groups, int numGroups);
+    // move the gates that only scale the local state into gg.globalPhase
+    void foldGlobalPhase(GateGroup& gg);
+    // flip the frame of the global target of an X / Y that getGate lowered to a phase
+    void trackPauliFrame(const Gate& gate);
+    // X gates on the qubits of the frame that the communication into lg made local
+    void resolvePauliFrame(LocalGroup& lg);
+#ifdef LAZY_ACTIVATION
+    // local positions holding every nonzero amplitude once the groups have run
+    int activePrefix(const GateGroup* groups, int numGroups);
+#endif
+
+    void setState(const State& newState) { state = newState; }
+
+    // utils
+    idx_t toPhyQubitSet(idx_t logicQubitset) const;
+    idx_t fillRelatedQubits(idx_t related) const;
+    KernelGate getGate(const Gate& gate, idx_t part_id, int numLocalQubits, idx_t relatedLogicQb, const std::map<int, int>& toID) const;
+
+    // internal
+    // input: physical, output logic -> share. Local qubits outside tileQubits (physical) get no id.
+    std::map<int, int> getLogicShareMap(idx_t relatedQubits, int numLocalQubits, idx_t tileQubits = ~idx_t(0)) const;
+
+    State state;
+    idx_t pauliFrame; // logic qubits whose value is the complement of their position bit (global qubits only)
+    idx_t activeLogicQb; // logic qubits targeted by a non-diagonal gate so far
+
+    // constants
+    int numQubits;
+
+    //schedule
+    Schedule& schedule;
+};
@@ -0,0 +1,362 @@
+#include "parser.h"
+#include "uqc.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& filename): data(nullptr), size(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        printf("fail to open %s\n", filename.c_str());
+        exit(1);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("fail to stat %s\n", filename.c_str());
+        exit(1);
+    }
+    size = st.st_size;
+    if (size > 0) {
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            printf("fail to mmap %s\n", filename.c_str());
+            exit(1);
+        }
+        madvise(addr, size, MADV_SEQUENTIAL);
+        data = reinterpret_cast<const char*>(addr);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data != nullptr)
+        munmap(const_cast<char*>(data), size);
+}
+
+namespace {
+
+const int MAX_PARAMS = 3;
+const int MAX_QUBITS = 3;
+const int MAX_NAME_LEN = 4;
+
+typedef Gate (*GateBuilder)(const int q[], const value_t p[]);
+
+struct GateEntry {
+    const char* name;
+    int numQubits;
+    int numParams;
+    GateBuilder build;
+};
+
+const GateEntry gateEntries[] = {
+    {"cx", 2, 0, [](const int q[], const value_t p[]) { return Gate::CNOT(q[0], q[1]); }},
+    {"cy", 2, 0, [](const int q[], const value_t p[]) { return Gate::CY(q[0], q[1]); }},
+    {"cz", 2, 0, [](const int q[], const value_t p[]) { return Gate::CZ(q[0], q[1]); }},
+    {"h", 1, 0, [](const int q[], const value_t p[]) { return Gate::H(q[0]); }},
+    {"x", 1, 0, [](const int q[], const value_t p[]) { return Gate::X(q[0]); }},
+    {"y", 1, 0, [](const int q[], const value_t p[]) { return Gate::Y(q[0]); }},
+    {"z", 1, 0, [](const int q[], const value_t p[]) { return Gate::Z(q[0]); }},
+    {"s", 1, 0, [](const int q[], const value_t p[]) { return Gate::S(q[0]); }},
+    {"sdg", 1, 0, [](const int q[], const value_t p[]) { return Gate::SDG(q[0]); }},
+    {"t", 1, 0, [](const int q[], const value_t p[]) { return Gate::T(q[0]); }},
+    {"tdg", 1, 0, [](const int q[], const value_t p[]) { return Gate::TDG(q[0]); }},
+    {"crx", 2, 1, [](const int q[], const value_t p[]) { return Gate::CRX(q[0], q[1], p[0]); }},
+    {"cry", 2, 1, [](const int q[], const value_t p[]) { return Gate::CRY(q[0], q[1], p[0]); }},
+    {"crz", 2, 1, [](const int q[], const value_t p[]) { return Gate::CRZ(q[0], q[1], p[0]); }},
+    {"cu1", 2, 1, [](const int q[], const value_t p[]) { return Gate::CU1(q[0], q[1], p[0]); }},
+    {"u1", 1, 1, [](const int q[], const value_t p[]) { return Gate::U1(q[0], p[0]); }},
+    {"u2", 1, 2, [](const int q[], const value_t p[]) { return Gate::U2(q[0], p[0], p[1]); }},
+    {"u3", 1, 3, [](const int q[], const value_t p[]) { return Gate::U3(q[0], p[0], p[1], p[2]); }},
+    {"rx", 1, 1, [](const int q[], const value_t p[]) { return Gate::RX(q[0], p[0]); }},
+    {"ry", 1, 1, [](const int q[], const value_t p[]) { return Gate::RY(q[0], p[0]); }},
+    {"rz", 1, 1, [](const int q[], const value_t p[]) { return Gate::RZ(q[0], p[0]); }},
+    {"rzz", 2, 1, [](const int q[], const value_t p[]) { return Gate::RZZ(q[0], q[1], p[0]); }},
+    {"swap", 2, 0, [](const int q[], const value_t p[]) { return Gate::SWAP(q[0], q[1]); }},
+    {"ccx", 3, 0, [](const int q[], const value_t p[]) { return Gate::MCU({q[0], q[1]}, q[2], {cpx(0), cpx(1), cpx(1), cpx(0)}); }},
+};
+
+// all gate names fit in 4 bytes, so a name is packed into one uint32 key and
+// looked up in a small open-addressing table instead of a strcmp chain
+inline uint32_t pack_name(const char* s, int len) {
+    uint32_t key = 0;
+    for (int i = 0; i < len; i++)
+        key |= uint32_t((unsigned char) s[i]) << (i * 8);
+    return key;
+}
+
+class GateTable {
+public:
+    GateTable() {
+        memset(keys, 0, sizeof(keys));
+        memset(entries, 0, sizeof(entries));
+        for (auto& e: gateEntries) {
+            uint32_t key = pack_name(e.name, strlen(e.name));
+            int slot = hash(key);
+            while (entries[slot] != nullptr)
+                slot = (slot + 1) & (TABLE_SIZE - 1);
+            keys[slot] = key;
+            entries[slot] = &e;
+        }
+    }
+    const GateEntry* find(const char* s, int len) const {
+        if (len > MAX_NAME_LEN) return nullptr;
+        uint32_t key = pack_name(s, len);
+        for (int slot = hash(key); entries[slot] != nullptr; slot = (slot + 1) & (TABLE_SIZE - 1)) {
+            if (keys[slot] == key) return entries[slot];
+        }
+        return nullptr;
+    }
+private:
+    static const int TABLE_BIT = 6;
+    static const int TABLE_SIZE = 1 << TABLE_BIT;
+    static int hash(uint32_t key) { return (key * 2654435761u) >> (32 - TABLE_BIT); }
+    uint32_t keys[TABLE_SIZE];
+    const GateEntry* entries[TABLE_SIZE];
+};
+
+const GateTable gateTable;
+
+inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* next_line(const char* p, const char* end) {
+    const char* nl = reinterpret_cast<const char*>(memchr(p, '\n', end - p));
+    return nl == nullptr ? end : nl + 1;
+}
+
+[[noreturn]] void parse_error(const char* msg, const char* line, const char* end) {
+    const char* eol = reinterpret_cast<const char*>(memchr(line, '\n', end - line));
+    int len = std::min(int((eol == nullptr ? end : eol) - line), 200);
+    printf("%s: %.*s\n", msg, len, line);
+    exit(1);
+}
+
+// <x> | pi | pi*<x> | pi/<x>, with an optional leading minus sign
+value_t parse_param(const char* &p, const char* end, const char* line) {
+    const value_t pi = acos(-1);
+    char buf[64];
+    int len = 0;
+    while (p < end && *p != ',' && *p != ')' && *p != '\n') {
+        if (!is_blank(*p)) {
+            if (len + 1 >= int(sizeof(buf))) parse_error("parameter too long", line, end);
+            buf[len++] = *p;
+        }
+        p++;
+    }
+    buf[len] = '\0';
+    const char* s = buf;
+    value_t sign = 1;
+    if (*s == '-') { sign = -1; s++; }
+    if (s[0] == 'p' && s[1] == 'i') {
+        if (s[2] == '*') return sign * pi * strtod(s + 3, nullptr);
+        if (s[2] == '/') return sign * pi / strtod(s + 3, nullptr);
+        return sign * pi;
+    }
+    return sign * strtod(s, nullptr);
+}
+
+inline int parse_int(const char* &p, const char* end) {
+    int x = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        x = x * 10 + (*p - '0');
+        p++;
+    }
+    return x;
+}
+
+enum class LineKind { EMPTY, QREG, GATE };
+
+// parses the statement starting at `line`; returns the start of the next line
+const char* parse_line(const char* line, const char* end, LineKind& kind, int& numQubits, std::vector<Gate>& gates) {
+    const char* p = line;
+    while (p < end && is_blank(*p)) p++;
+    const char* name = p;
+    while (p < end && !is_blank(*p) && *p != '(' && *p != '\n' && *p != ';') p++;
+    int nameLen = p - name;
+    kind = LineKind::EMPTY;
+    if (nameLen == 0 || (nameLen >= 2 && name[0] == '/' && name[1] == '/'))
+        return next_line(p, end);
+    if ((nameLen == 8 && memcmp(name, "OPENQASM", 8) == 0) || (nameLen == 7 && memcmp(name, "include", 7) == 0))
+        return next_line(p, end);
+    if (nameLen == 4 && memcmp(name, "qreg", 4) == 0) {
+        while (p < end && *p != '[' && *p != '\n') p++;
+        if (p == end || *p != '[') parse_error("invalid qreg", line, end);
+        p++;
+        numQubits = parse_int(p, end);
+        kind = LineKind::QREG;
+        return next_line(p, end);
+    }
+    // permute q[a0],q[a1],...: the state of the i-th lowest listed qubit moves to q[ai]
+    if (nameLen == 7 && memcmp(name, "permute", 7) == 0) {
+        std::vector<int> dst;
+        while (p < end && *p != ';' && *p != '\n') {
+            if (*p == '[') {
+                p++;
+                dst.push_back(parse_int(p, end));
+            } else {
+                p++;
+            }
+        }
+        std::vector<int> src = dst;
+        std::sort(src.begin(), src.end());
+        if (src.empty() || std::adjacent_find(src.begin(), src.end()) != src.end())
+            parse_error("invalid permute", line, end);
+        std::vector<int> perm(src.back() + 1);
+        for (int i = 0; i <= src.back(); i++)
+            perm[i] = i;
+        for (size_t i = 0; i < src.size(); i++)
+            perm[src[i]] = dst[i];
+        for (auto& g: Gate::permutation(perm))
+            gates.push_back(g);
+        kind = LineKind::GATE;
+        return next_line(p, end);
+    }
+
+    const GateEntry* entry = gateTable.find(name, nameLen);
+    if (entry == nullptr) {
+        printf("unrecognized token %.*s\n", nameLen, name);
+        exit(1);
+    }
+    value_t params[MAX_PARAMS];
+    int numParams = 0;
+    if (p < end && *p == '(') {
+        do {
+            p++;
+            if (numParams == MAX_PARAMS) parse_error("too many parameters", line, end);
+            params[numParams++] = parse_param(p, end, line);
+        } while (p < end && *p == ',');
+        if (p == end || *p != ')') parse_error("missing ')'", line, end);
+        p++;
+    }
+    int qid[MAX_QUBITS];
+    int numQids = 0;
+    while (p < end && *p != ';' && *p != '\n') {
+        if (*p == '[') {
+            p++;
+            if (numQids == MAX_QUBITS) parse_error("too many qubits", line, end);
+            qid[numQids++] = parse_int(p, end);
+        } else {
+            p++;
+        }
+    }
+    if (numParams != entry->numParams || numQids != entry->numQubits)
+        parse_error("wrong number of operands", line, end);
+    gates.push_back(entry->build(qid, params));
+    kind = LineKind::GATE;
+    return next_line(p, end);
+}
+
+void parse_body(const char* p, const char* end, std::vector<Gate>& gates) {
+    // one statement per line, so the line count bounds the gate count (permute aside)
+    gates.reserve(gates.size() + std::count(p, end, '\n') + 1);
+    while (p < end) {
+        LineKind kind;
+        int n = -1;
+        p = parse_line(p, end, kind, n, gates);
+        if (kind == LineKind::QREG) {
+            printf("multiple qreg is not supported\n");
+            exit(1);
+        }
+    }
+}
+
+#ifdef PARALLEL_PARSE
+const size_t PARALLEL_PARSE_MIN_SIZE = 1 << 20;
+
+// splits the body into line-aligned chunks, parses them on all threads and
+// concatenates the results in file order
+void parse_body_parallel(const char* begin, const char* end, std::vector<Gate>& gates) {
+    int numChunks = omp_get_max_threads() * 4;
+    std::vector<const char*> bounds(numChunks + 1);
+    bounds[0] = begin;
+    bounds[numChunks] = end;
+    for (int i = 1; i < numChunks; i++)
+        bounds[i] = next_line(begin + (end - begin) / numChunks * i, end);
+
+    std::vector<std::vector<Gate>> parts(numChunks);
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numChunks; i++)
+        parse_body(bounds[i], bounds[i + 1], parts[i]);
+
+    std::vector<size_t> offsets(numChunks + 1, gates.size());
+    for (int i = 0; i < numChunks; i++)
+        offsets[i + 1] = offsets[i] + parts[i].size();
+    gates.resize(offsets[numChunks]);
+    // the threads drew gateIDs from their own blocks, renumber them in file order
+    int firstID = Gate::reserveIDs(offsets[numChunks] - offsets[0]);
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numChunks; i++) {
+        for (size_t j = 0; j < parts[i].size(); j++) {
+            Gate& g = gates[offsets[i] + j];
+            g = std::move(parts[i][j]);
+            g.gateID = firstID + (offsets[i] - offsets[0]) + j;
+        }
+        std::vector<Gate>().swap(parts[i]);
+    }
+}
+#endif
+
+}
+
+std::unique_ptr<Circuit> parse_circuit(const std::string &filename) {
+    MappedFile file(filename);
+    const char* p = file.data;
+    const char* end = file.data + file.size;
+    int n = -1;
+    while (p < end && n < 0) {
+        LineKind kind;
+        std::vector<Gate> dummy;
+        p = parse_line(p, end, kind, n, dummy);
+        if (kind == LineKind::GATE) {
+            printf("gate before qreg\n");
+            exit(1);
+        }
+    }
+    if (n < 0) {
+        printf("fail to load circuit\n");
+        exit(1);
+    }
+#if MODE == 0
+    auto c = std::make_unique<Circuit>(n);
+#elif MODE == 1 || MODE == 2
+    auto c = std::make_unique<Circuit>(n * 2);
+#endif
+    std::vector<Gate> gates;
+#ifdef PARALLEL_PARSE
+    if (size_t(end - p) >= PARALLEL_PARSE_MIN_SIZE && omp_get_max_threads() > 1)
+        parse_body_parallel(p, end, gates);
+    else
+        parse_body(p, end, gates);
+#else
+    parse_body(p, end, gates);
+#endif
+    c->addGates(std::move(gates));
+    return c;
+}
+
+std::unique_ptr<Circuit> load_circuit(const std::string &filename) {
+#if USE_MPI
+    // only rank 0 compiles, the other ranks get the schedule in Circuit::compile
+    // and do not need the gates, so they skip reading the file
+    if (MyMPI::rank != 0) {
+        int numQubits;
+        checkMPIErrors(MPI_Bcast(&numQubits, 1, MPI_INT, 0, MPI_COMM_WORLD));
+        return std::make_unique<Circuit>(numQubits);
+    }
+#endif
+    auto c = is_uqc_file(filename) ? load_uqc(filename) : parse_circuit(filename);
+#if USE_MPI
+    int numQubits = c->numQubits;
+    checkMPIErrors(MPI_Bcast(&numQubits, 1, MPI_INT, 0, MPI_COMM_WORLD));
+#endif
+    return c;
+}
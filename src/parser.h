@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "circuit.h"
+
+// read-only view of a whole file, backed by mmap
+struct MappedFile {
+    MappedFile(const std::string& filename);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+    const char* data;
+    size_t size;
+};
+
+std::unique_ptr<Circuit> parse_circuit(const std::string &filename);
+
+// loads a .uqc or qasm file. With USE_MPI, only rank 0 reads the file; the other
+// ranks return a circuit without gates, which is enough as they receive the
+// compiled schedule
+std::unique_ptr<Circuit> load_circuit(const std::string &filename);
@@ -43,6 +43,8 @@ GateGroup GateGroup::merge(const GateGroup& a, const GateGroup& b) {
 
 idx_t GateGroup::newRelated(idx_t relatedQubits, const Gate& gate, idx_t localQubits, bool enableGlobal) {
       if (enableGlobal) {
+        if (gate.isFramePauli() && !(localQubits >> gate.targetQubit & 1))
+            return relatedQubits;
         if (!gate.isDiagonal()) {
             relatedQubits |= idx_t(1) << gate.targetQubit;
             if (gate.isTwoQubitGate()) {
@@ -55,7 +57,7 @@ idx_t GateGroup::newRelated(idx_t relatedQubits, const Gate& gate, idx_t localQu
         if (gate.isControlGate() && (localQubits >> gate.controlQubit & 1))
             relatedQubits |= idx_t(1) << gate.controlQubit;
         if (gate.isMCGate())
-            relatedQubits |= gate.encodeQubit;
+            relatedQubits |= gate.encodeQubit & localQubits;
         if (gate.isTwoQubitGate())
             relatedQubits |= idx_t(1) << gate.encodeQubit;
     }
@@ -67,6 +69,28 @@ void GateGroup::addGate(const Gate& gate, idx_t localQubits, bool enableGlobal)
     relatedQubits = newRelated(relatedQubits, gate, localQubits, enableGlobal);
 }
 
+idx_t GateGroup::blockQubitSet(int numLocalQubits, int blockQubits) const {
+    idx_t ret = relatedQubits;
+    if (bitCount(ret) < blockQubits)
+        ret = state.fillRelated(ret, blockQubits);
+    // local qubits outside the related set (diagonal targets, controls) are read from the block id
+    auto addLocal = [&](int q) {
+        if (state.pos[q] < numLocalQubits)
+            ret |= idx_t(1) << q;
+    };
+    for (auto& gate: gates) {
+        addLocal(gate.targetQubit);
+        if (gate.isControlGate())
+            addLocal(gate.controlQubit);
+        if (gate.isMCGate())
+            for (auto q: gate.controlQubits)
+                addLocal(q);
+        if (gate.isTwoQubitGate())
+            addLocal(gate.encodeQubit);
+    }
+    return ret;
+}
+
 GateGroup GateGroup::copyGates() {
     GateGroup ret;
     ret.gates = this->gates;
@@ -81,7 +105,11 @@ void Schedule::dump(int numQubits) {
         for (auto& gg: lg.overlapGroups) {
             switch (gg.backend) {
                 case Backend::BLAS: printf("<BLAS>\n"); break;
-                case Backend::PerGate: printf("<PerGate>\n"); break;
+                case Backend::PerGate: {
+                    if (gg.superGroup > 1) printf("<PerGate, super-group of %d>\n", gg.superGroup);
+                    else printf("<PerGate>\n");
+                    break;
+                }
                 case Backend::None: printf("<None\n>"); break;
             }
             for (const Gate& gate: gg.gates) {
@@ -124,7 +152,11 @@ void Schedule::dump(int numQubits) {
             printf("%llx ", gg.relatedQubits);
             switch (gg.backend) {
                 case Backend::BLAS: printf("<BLAS>\n"); break;
-                case Backend::PerGate: printf("<PerGate>\n"); break;
+                case Backend::PerGate: {
+                    if (gg.superGroup > 1) printf("<PerGate, super-group of %d>\n", gg.superGroup);
+                    else printf("<PerGate>\n");
+                    break;
+                }
                 case Backend::None: printf("<None\n>"); break;
             }
             for (const Gate& gate: gg.gates) {
@@ -190,175 +222,17 @@ void Schedule::dump(int numQubits) {
     fflush(stdout);
 }
 
-std::vector<unsigned char> State::serialize() const {
-    assert(pos.size() == layout.size());
-    auto num_ele = pos.size();
-
-    std::vector<unsigned char> result;
-    result.resize(sizeof(num_ele));
-    auto arr = result.data();
-    int cur = 0;
-    SERIALIZE_STEP(num_ele);
-    SERIALIZE_VECTOR(pos, result);
-    SERIALIZE_VECTOR(layout, result);
-    return result;
-}
-
-State State::deserialize(const unsigned char* arr, int& cur) {
-    State s;
-    decltype(s.pos.size()) num_ele;
-
-    DESERIALIZE_STEP(num_ele);
-    DESERIALIZE_VECTOR(s.pos, num_ele);
-    DESERIALIZE_VECTOR(s.layout, num_ele);
-
-    return s;
-}
-
-std::vector<unsigned char> GateGroup::serialize() const {
-    auto num_gates = gates.size();
-    auto num_perm = cuttPerm.size();
-
-    std::vector<unsigned char> result;
-    result.resize(sizeof(num_gates) + sizeof(relatedQubits) + sizeof(num_perm) + sizeof(matQubit) + sizeof(Backend));
-    auto arr = result.data();
-    int cur = 0;
-    SERIALIZE_STEP(num_gates);
-    SERIALIZE_STEP(relatedQubits);
-    SERIALIZE_STEP(num_perm);
-    SERIALIZE_STEP(matQubit);
-    SERIALIZE_STEP(backend);
-
-    auto s = state.serialize();
-    result.insert(result.end(), s.begin(), s.end());
-
-    for (auto& gate: gates) {
-        auto g = gate.serialize();
-        result.insert(result.end(), g.begin(), g.end());
-    }
-
-    SERIALIZE_VECTOR(cuttPerm, result);
-
-    return result;
-}
-
-GateGroup GateGroup::deserialize(const unsigned char* arr, int& cur) {
-    GateGroup gg;
-    decltype(gg.gates.size()) num_gates;
-    decltype(gg.cuttPerm.size()) num_perm;
-
-    DESERIALIZE_STEP(num_gates);
-    DESERIALIZE_STEP(gg.relatedQubits);
-    DESERIALIZE_STEP(num_perm);
-    DESERIALIZE_STEP(gg.matQubit);
-    DESERIALIZE_STEP(gg.backend);
-
-    gg.state = State::deserialize(arr, cur);
-
-    for (decltype(num_gates) i = 0; i < num_gates; i++) {
-        gg.gates.push_back(Gate::deserialize(arr, cur));
-    }
-
-    DESERIALIZE_VECTOR(gg.cuttPerm, num_perm);
-
-    return gg;
-}
-
-std::vector<unsigned char> LocalGroup::serialize() const {
-    auto num_a2a = a2aComm.size();
-    auto num_perm = cuttPerm.size();
-    auto num_og = overlapGroups.size();
-    auto num_fg = fullGroups.size();
-
-    std::vector<unsigned char> result;
-    result.resize(sizeof(a2aCommSize) + sizeof(num_a2a) + sizeof(num_perm) + sizeof(num_og) + sizeof(num_fg) + sizeof(relatedQubits));
-    auto arr = result.data();
-    int cur = 0;
-    SERIALIZE_STEP(a2aCommSize);
-    SERIALIZE_STEP(num_a2a);
-    SERIALIZE_STEP(num_perm);
-    SERIALIZE_STEP(num_og);
-    SERIALIZE_STEP(num_fg);
-    SERIALIZE_STEP(relatedQubits);
-    
-    SERIALIZE_VECTOR(a2aComm, result);
-    SERIALIZE_VECTOR(cuttPerm, result);
-
-    auto s = state.serialize();
-    result.insert(result.end(), s.begin(), s.end());
-
-    for (auto& gateGroup: overlapGroups) {
-        auto gg = gateGroup.serialize();
-        result.insert(result.end(), gg.begin(), gg.end());
-    }
-
-    for (auto& gateGroup: fullGroups) {
-        auto gg = gateGroup.serialize();
-        result.insert(result.end(), gg.begin(), gg.end());
-    }
-
-    return result;
-}
-
-
-LocalGroup LocalGroup::deserialize(const unsigned char* arr, int& cur) {
-    LocalGroup s;
-    decltype(s.a2aComm.size()) num_a2a;
-    decltype(s.cuttPerm.size()) num_perm;
-    decltype(s.overlapGroups.size()) num_og;
-    decltype(s.fullGroups.size()) num_fg;
-
-    DESERIALIZE_STEP(s.a2aCommSize);
-    DESERIALIZE_STEP(num_a2a);
-    DESERIALIZE_STEP(num_perm);
-    DESERIALIZE_STEP(num_og);
-    DESERIALIZE_STEP(num_fg);
-    DESERIALIZE_STEP(s.relatedQubits);
-
-    DESERIALIZE_VECTOR(s.a2aComm, num_a2a);
-    DESERIALIZE_VECTOR(s.cuttPerm, num_perm);
-
-    s.state = State::deserialize(arr, cur);
-
-    for (decltype(num_og) i = 0; i < num_og; i++) {
-        s.overlapGroups.push_back(GateGroup::deserialize(arr, cur));
-    }
-
-    for (decltype(num_fg) i = 0; i < num_fg; i++) {
-        s.fullGroups.push_back(GateGroup::deserialize(arr, cur));
-    }
-
-    return s;
-}
-
-std::vector<unsigned char> Schedule::serialize() const {
-    auto num_lg = localGroups.size();
-    std::vector<unsigned char> result;
-    result.resize(sizeof(num_lg));
-    auto arr = result.data();
-    int cur = 0;
-    SERIALIZE_STEP(num_lg);
-
-    auto s = finalState.serialize();
-    result.insert(result.end(), s.begin(), s.end());
-
-    for (auto& localGroup: localGroups) {
-        auto lg = localGroup.serialize();
-        result.insert(result.end(), lg.begin(), lg.end());
-    }
-    return result;
-}
-
-
-Schedule Schedule::deserialize(const unsigned char* arr, int& cur) {
-    Schedule s;
-    decltype(s.localGroups.size()) num_lg;
-    DESERIALIZE_STEP(num_lg);
-    s.finalState = State::deserialize(arr, cur);
-    for (decltype(num_lg) i = 0; i < num_lg; i++) {
-        s.localGroups.push_back(LocalGroup::deserialize(arr, cur));
+idx_t State::fillRelated(idx_t relatedLogicQb, int blockQubits) const {
+    int cnt = bitCount(relatedLogicQb);
+    for (int i = 0; i < blockQubits; i++) {
+        if (!(relatedLogicQb & (1ll << layout[i]))) {
+            cnt++;
+            relatedLogicQb |= (1ll << layout[i]);
+            if (cnt == blockQubits)
+                break;
+        }
     }
-    return s;
+    return relatedLogicQb;
 }
 
 std::vector<int> gen_perm_vector(int len) {
@@ -439,6 +313,53 @@ State GateGroup::initState(const State& oldState, int numLocalQubits) {
     UNREACHABLE();
 }
 
+int LocalGroup::fuseGroups(int blockQubits) {
+    // groups run in order, so appending the gates of a group to the one before
+    // it keeps the gate order
+    std::vector<GateGroup> fused;
+    for (auto& gg: fullGroups) {
+        if (fused.size() > 0) {
+            GateGroup& last = fused.back();
+            if (last.backend == Backend::PerGate && gg.backend == Backend::PerGate
+                && bitCount(last.relatedQubits | gg.relatedQubits) <= blockQubits
+                && last.gates.size() + gg.gates.size() < size_t(MAX_GATE)) {
+                last.gates.insert(last.gates.end(), gg.gates.begin(), gg.gates.end());
+                last.relatedQubits |= gg.relatedQubits;
+                continue;
+            }
+        }
+        fused.push_back(std::move(gg));
+    }
+    int saved = fullGroups.size() - fused.size();
+    fullGroups = std::move(fused);
+    return saved;
+}
+
+int LocalGroup::formSuperGroups(int numLocalQubits, int blockQubits, int tileQubits) {
+    int saved = 0;
+    size_t i = 0;
+    while (i < fullGroups.size()) {
+        // per-gate groups keep the state, so all groups of a run see the same layout
+        size_t j = i;
+        idx_t tile = 0;
+        while (j < fullGroups.size() && fullGroups[j].backend == Backend::PerGate) {
+            idx_t t = tile | fullGroups[j].blockQubitSet(numLocalQubits, blockQubits);
+            if (bitCount(t) > tileQubits)
+                break;
+            tile = t;
+            j++;
+        }
+        if (j - i > 1) {
+            fullGroups[i].superGroup = j - i;
+            saved += j - i - 1;
+            i = j;
+        } else {
+            i++;
+        }
+    }
+    return saved;
+}
+
 State LocalGroup::initState(const State& oldState, int numQubits, const std::vector<int>& newGlobals, idx_t overlapGlobals, idx_t overlapRelated, int globalBit) {
     int numLocalQubits = numQubits - globalBit;
     auto pos = oldState.pos, layout = oldState.layout;
@@ -751,13 +672,18 @@ void GateGroup::initCPUMatrix(int numLocalQubit) {
             if (gate.isMCGate()) {
                 int t = pos[gate.targetQubit];
                 idx_t cbits = 0;
+                bool skip = false;
                 for (auto q: gate.controlQubits) {
                     int c = pos[q];
-                    if (c >= numLocalQubit && !isHiGPU(c))
+                    // global controls are fixed per rank: low skips the gate, high is dropped
+                    if (c >= numLocalQubit) {
+                        if (!isHiGPU(c)) skip = true;
                         continue;
+                    }
                     assert(c < numMatQubits);
                     cbits |= 1ll << c;
                 }
+                if (skip) continue;
                 if (t >= numLocalQubit) {
                     bool isHi = isHiGPU(t);
                     auto val = gate.mat[isHi][isHi];
@@ -836,7 +762,10 @@ void GateGroup::initGPUMatrix() {
 #ifdef USE_GPU
     CudaImpl::initGPUMatrix(deviceMats, matQubit, matrix);
 #else
-    UNIMPLEMENTED();
+    // the cpu executor reads the host matrix directly
+    deviceMats.clear();
+    for (auto& mat: matrix)
+        deviceMats.push_back(mat.get());
 #endif
 }
 
@@ -871,6 +800,28 @@ void Schedule::initMatrix(int numQubits) {
 #endif
 
 
+State Schedule::circuitState(const State& compiledState) const {
+    if (qubitMap.pos.empty())
+        return compiledState;
+    State ret(compiledState.pos.size());
+    for (size_t q = 0; q < compiledState.pos.size(); q++) {
+        ret.pos[q] = compiledState.pos[qubitMap.pos[q]];
+        ret.layout[ret.pos[q]] = q;
+    }
+    return ret;
+}
+
+idx_t Schedule::circuitQubitSet(idx_t compiledQubits) const {
+    if (qubitMap.pos.empty())
+        return compiledQubits;
+    idx_t ret = 0;
+    for (size_t q = 0; q < qubitMap.pos.size(); q++) {
+        if (compiledQubits >> qubitMap.pos[q] & 1)
+            ret |= idx_t(1) << q;
+    }
+    return ret;
+}
+
 void Schedule::initCuttPlans(int numLocalQubits) {
     std::vector<transHandle*> transPlanPointers;
     std::vector<int*> transPermPointers;
@@ -38,8 +38,8 @@ struct State {
         }
     }
 
-    std::vector<unsigned char> serialize() const;
-    static State deserialize(const unsigned char* arr, int& cur);
+    // fill relatedLogicQb up to blockQubits qubits with the lowest physical qubits
+    idx_t fillRelated(idx_t relatedLogicQb, int blockQubits) const;
 };
 
 struct GateGroup {
@@ -49,15 +49,28 @@ struct GateGroup {
     std::vector<int> cuttPerm;
     int matQubit;
     Backend backend;
+    // number of consecutive groups, starting at this one, that run as one
+    // super-group on L2-sized tiles (1: the group runs alone)
+    int superGroup;
 
     std::vector<transHandle> transPlans;
 
     std::vector<std::unique_ptr<cpx[]>> matrix;
     std::vector<cpx*> deviceMats;
 
+    // filled by Lowering::lower() for the per-gate groups of this rank, not serialized
+    std::vector<KernelGate> kernelGates; // [localGPU][gate], empty if the group only scales the local state
+    std::vector<cpx> globalPhase; // [localGPU] product of the GCC / GZZ / GII gates folded out of kernelGates
+    idx_t phyRelatedQubits;
+    idx_t tileQubits; // physical tile of a super-group head, 0 if it runs group by group
+    int activeQubits; // the group runs on the first 2^activeQubits amplitudes of the local state
+#ifdef CPU_BIAS_TABLE
+    std::vector<unsigned int> blockBias; // bias of every block of a per-gate group, empty for the kernels to use PDEP
+#endif
+
     GateGroup(GateGroup&&) = default;
     GateGroup& operator = (GateGroup&&) = default;
-    GateGroup(): relatedQubits(0) {}
+    GateGroup(): relatedQubits(0), superGroup(1), phyRelatedQubits(0), tileQubits(0), activeQubits(0) {}
     GateGroup copyGates();
 
     static GateGroup merge(const GateGroup& a, const GateGroup& b);
@@ -65,9 +78,8 @@ struct GateGroup {
     void addGate(const Gate& g, idx_t localQubits, bool enableGlobal);
     
     bool contains(int i) { return (relatedQubits >> i) & 1; }
-    
-    std::vector<unsigned char> serialize() const;
-    static GateGroup deserialize(const unsigned char* arr, int& cur);
+    // logic qubits that one block of this (per-gate) group reads or writes
+    idx_t blockQubitSet(int numLocalQubits, int blockQubits) const;
 
     State initState(const State& oldState, int numLocalQubits);
     State initPerGateState(const State& oldState);
@@ -89,28 +101,44 @@ struct LocalGroup {
     idx_t relatedQubits;
 
     std::vector<transHandle> transPlans;
+    // filled by Lowering::lower(), not serialized: X gates that resolve the
+    // Pauli frame of the qubits made local by the communication into this group
+    std::vector<GateGroup> frameGroups;
     
     LocalGroup() = default;
     LocalGroup(LocalGroup&&) = default;
 
     bool contains(int i) { return (relatedQubits >> i) & 1; }
+    // merge consecutive per-gate fullGroups whose related qubits fit in one block, returns the sweeps saved
+    int fuseGroups(int blockQubits);
+    // mark runs of per-gate fullGroups whose blocks together touch at most tileQubits qubits, returns the sweeps saved
+    int formSuperGroups(int numLocalQubits, int blockQubits, int tileQubits);
     void getCuttPlanPointers(int numLocalQubits, std::vector<transHandle*> &transPlanPointers, std::vector<int*> &transPermPointers, std::vector<int> &locals, bool isFirstGroup = false);
     State initState(const State& oldState, int numQubits, const std::vector<int>& newGlobals, idx_t overlapGlobals, idx_t overlapRelated, int globalBit);
     State initFirstGroupState(const State& oldState, int numQubits, const std::vector<int>& newGlobals);
     State initStateInplace(const State& oldState, int numQubits, const std::vector<int>& newGlobals, idx_t overlapGlobals, int globalBit);
-    std::vector<unsigned char> serialize() const;
-    static LocalGroup deserialize(const unsigned char* arr, int& cur);
 };
 
 struct Schedule {
     std::vector<LocalGroup> localGroups;
-    State finalState;
+    State finalState; // of the qubits of the circuit
+    // qubitMap.pos[q]: the qubit of the compiled gates that holds qubit q of the circuit (see Compiler::absorbSwaps)
+    State qubitMap;
+    bool lowered = false;
+    // qubits of the circuit whose value is flipped in the final state, set by Lowering::lower()
+    idx_t pauliFrame = 0;
     
     void dump(int numQubits);
-    std::vector<unsigned char> serialize() const;
-    static Schedule deserialize(const unsigned char* arr, int& cur);
+    // flat, offset-based encoding used for the broadcast and the schedule cache
+    std::vector<unsigned char> encode() const;
+    static Schedule decode(const unsigned char* buf, size_t size);
+    static bool tryDecode(const unsigned char* buf, size_t size, Schedule& s); // false on a corrupted buffer
     void initMatrix(int numQubits);
     void initCuttPlans(int numLocalQubits);
+    // state of the qubits of the circuit from the state of the compiled qubits
+    State circuitState(const State& compiledState) const;
+    // qubits of the circuit held by a set of compiled qubits
+    idx_t circuitQubitSet(idx_t compiledQubits) const;
 };
 
 void removeGates(std::vector<Gate>& remain, const std::vector<Gate>& remove); // remain := remain - remove        
\ No newline at end of file
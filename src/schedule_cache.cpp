@@ -0,0 +1,178 @@
+#include "schedule_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "logger.h"
+
+namespace ScheduleCache {
+
+#ifdef SCHEDULE_CACHE_DIR
+
+// bump when the schedule serialization changes
+const uint64_t CACHE_VERSION = 4;
+const uint64_t CACHE_MAGIC = 0x454843534d4d5551ull; // "QUMMSCHE"
+
+class Hasher {
+public:
+    Hasher(): h(0xcbf29ce484222325ull) {}
+    template<typename T>
+    void add(const T& x) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(&x);
+        for (size_t i = 0; i < sizeof(T); i++) {
+            h ^= p[i];
+            h *= 0x100000001b3ull;
+        }
+    }
+    void add(const cpx& x) { add(x.real()); add(x.imag()); }
+    void add(const Error& e) { add(int(e.type)); add(e.mat00); add(e.mat01); add(e.mat10); add(e.mat11); }
+    uint64_t value() const { return h; }
+private:
+    uint64_t h;
+};
+
+std::string cache_file(uint64_t key) {
+    char name[32];
+    sprintf(name, "/%016llx.sched", (unsigned long long) key);
+    return std::string(SCHEDULE_CACHE_DIR) + name;
+}
+
+uint64_t hash(int numQubits, const std::vector<Gate>& gates) {
+    Hasher h;
+    h.add(CACHE_VERSION);
+    h.add(int(MODE)); h.add(int(GPU_BACKEND)); h.add(int(INPLACE)); h.add(int(sizeof(value_t)));
+    h.add(MyGlobalVars::blockQubits); h.add(COALESCE_GLOBAL); h.add(BLAS_MAT_LIMIT); h.add(MIN_MAT_SIZE);
+#ifdef ENABLE_OVERLAP
+    h.add(1);
+#else
+    h.add(0);
+#endif
+#ifdef ENABLE_TRANSFORM
+    h.add(1);
+#else
+    h.add(0);
+#endif
+#ifdef PAULI_FRAME
+    h.add(1);
+#else
+    h.add(0);
+#endif
+#ifdef LAZY_ACTIVATION
+    h.add(1);
+#else
+    h.add(0);
+#endif
+#ifdef CPU_L2_QUBITS
+    h.add(CPU_L2_QUBITS);
+#else
+    h.add(0);
+#endif
+    h.add(MyGlobalVars::bit); h.add(MyGlobalVars::numGPUs);
+    h.add(numQubits);
+    h.add(gates.size());
+    for (auto& g: gates) {
+        h.add(int(g.type));
+        h.add(g.targetQubit); h.add(g.controlQubit); h.add(g.encodeQubit);
+        for (int i = 0; i < 2; i++)
+            for (int j = 0; j < 2; j++)
+                h.add(g.mat[i][j]);
+        h.add(g.controlErrors.size());
+        for (auto& e: g.controlErrors) h.add(e);
+        h.add(g.targetErrors.size());
+        for (auto& e: g.targetErrors) h.add(e);
+    }
+    return h.value();
+}
+
+bool load(uint64_t key, Schedule& schedule) {
+    std::string filename = cache_file(key);
+    FILE* f = fopen(filename.c_str(), "rb");
+    if (f == nullptr) return false;
+    uint64_t header[3]; // magic, key, payload size
+    bool ok = fread(header, sizeof(header), 1, f) == 1 && header[0] == CACHE_MAGIC && header[1] == key;
+    std::vector<unsigned char> buffer;
+    if (ok) {
+        buffer.resize(header[2]);
+        ok = fread(buffer.data(), 1, buffer.size(), f) == buffer.size();
+    }
+    fclose(f);
+    ok = ok && Schedule::tryDecode(buffer.data(), buffer.size(), schedule);
+    if (!ok) {
+        Logger::add("Schedule Cache: ignore broken %s", filename.c_str());
+        schedule = Schedule();
+        return false;
+    }
+    Logger::add("Schedule Cache: hit %016llx", (unsigned long long) key);
+    return true;
+}
+
+static bool make_dir() {
+    if (mkdir(SCHEDULE_CACHE_DIR, 0755) != 0 && errno != EEXIST) {
+        Logger::add("Schedule Cache: fail to create %s", SCHEDULE_CACHE_DIR);
+        return false;
+    }
+    return true;
+}
+
+void store(uint64_t key, const Schedule& schedule) {
+    if (!make_dir()) return;
+    auto s = schedule.encode();
+    std::string filename = cache_file(key);
+    // write then rename, so that concurrent jobs never see a partial file
+    std::string tmpname = filename + ".tmp" + std::to_string(getpid());
+    FILE* f = fopen(tmpname.c_str(), "wb");
+    if (f == nullptr) {
+        Logger::add("Schedule Cache: fail to open %s", tmpname.c_str());
+        return;
+    }
+    uint64_t header[3] = {CACHE_MAGIC, key, s.size()};
+    bool ok = fwrite(header, sizeof(header), 1, f) == 1 && fwrite(s.data(), 1, s.size(), f) == s.size();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmpname.c_str(), filename.c_str()) != 0) {
+        unlink(tmpname.c_str());
+        Logger::add("Schedule Cache: fail to write %s", filename.c_str());
+        return;
+    }
+    Logger::add("Schedule Cache: store %016llx", (unsigned long long) key);
+}
+
+bool loadTuning(const std::string& name, int& value) {
+    std::string filename = std::string(SCHEDULE_CACHE_DIR) + "/" + name + ".tune";
+    FILE* f = fopen(filename.c_str(), "r");
+    if (f == nullptr) return false;
+    bool ok = fscanf(f, "%d", &value) == 1;
+    fclose(f);
+    return ok;
+}
+
+void storeTuning(const std::string& name, int value) {
+    if (!make_dir()) return;
+    std::string filename = std::string(SCHEDULE_CACHE_DIR) + "/" + name + ".tune";
+    std::string tmpname = filename + ".tmp" + std::to_string(getpid());
+    FILE* f = fopen(tmpname.c_str(), "w");
+    if (f == nullptr) {
+        Logger::add("Schedule Cache: fail to open %s", tmpname.c_str());
+        return;
+    }
+    bool ok = fprintf(f, "%d\n", value) > 0;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmpname.c_str(), filename.c_str()) != 0) {
+        unlink(tmpname.c_str());
+        Logger::add("Schedule Cache: fail to write %s", filename.c_str());
+    }
+}
+
+#else
+
+uint64_t hash(int numQubits, const std::vector<Gate>& gates) { return 0; }
+bool load(uint64_t key, Schedule& schedule) { return false; }
+void store(uint64_t key, const Schedule& schedule) {}
+bool loadTuning(const std::string& name, int& value) { return false; }
+void storeTuning(const std::string& name, int value) {}
+
+#endif
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "gate.h"
+#include "schedule.h"
+
+// on-disk cache of compiled schedules, enabled with SCHEDULE_CACHE_DIR
+namespace ScheduleCache {
+    // covers the gate list and every build/run knob the compiler depends on
+    uint64_t hash(int numQubits, const std::vector<Gate>& gates);
+    bool load(uint64_t key, Schedule& schedule);
+    void store(uint64_t key, const Schedule& schedule);
+    // runtime tuning results (e.g. the cpu block size), kept next to the schedules
+    bool loadTuning(const std::string& name, int& value);
+    void storeTuning(const std::string& name, int value);
+};
@@ -0,0 +1,267 @@
+#include "schedule.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "uqc.h"
+
+// Flat encoding of a Schedule. Every block starts at an 8-byte aligned offset
+// and blocks refer to each other by offsets from the start of the buffer, so
+// the gate groups can be decoded independently (and in parallel).
+//   schedule:    WireHeader | finalState | qubitMap | int64 localGroupOffsets[numLocalGroups]
+//   local group: WireLocalGroup | a2aComm | cuttPerm | state | int64 groupOffsets[numOverlap + numFull]
+//   gate group:  WireGateGroup | cuttPerm | state | gateIDs | UqcGate[numGates] | UqcError[numErrors]
+// A state is stored as int32 pos[stateSize] followed by int32 layout[stateSize].
+
+namespace {
+
+const uint64_t WIRE_MAGIC = 0x33455249574d5155ull; // "UQMWIRE3"
+
+struct WireHeader {
+    uint64_t magic;
+    uint64_t size;
+    int64_t numLocalGroups;
+    int32_t stateSize;
+    int32_t qubitMapSize;
+};
+
+struct WireLocalGroup {
+    int64_t relatedQubits;
+    int32_t a2aCommSize;
+    int32_t numA2a;
+    int32_t numPerm;
+    int32_t numOverlap;
+    int32_t numFull;
+    int32_t stateSize;
+};
+
+struct WireGateGroup {
+    int64_t relatedQubits;
+    int32_t numGates;
+    int32_t numErrors;
+    int32_t numPerm;
+    int32_t matQubit;
+    int32_t backend;
+    int32_t stateSize;
+    int32_t superGroup;
+    int32_t reserved;
+};
+
+static_assert(sizeof(int) == sizeof(int32_t), "int vectors are copied as int32");
+
+inline size_t align8(size_t x) { return (x + 7) & ~size_t(7); }
+
+// runs twice: without a buffer to measure the size, then to fill the buffer
+class Writer {
+public:
+    Writer(unsigned char* buf): buf(buf), cur(0) {}
+    bool counting() const { return buf == nullptr; }
+    size_t size() const { return cur; }
+    size_t skip(size_t len) {
+        size_t off = cur;
+        cur += align8(len);
+        return off;
+    }
+    size_t put(const void* p, size_t len) {
+        if (buf != nullptr && len > 0) memcpy(buf + cur, p, len);
+        return skip(len);
+    }
+    template<typename T>
+    size_t put(const T& x) { return put(&x, sizeof(T)); }
+    template<typename T>
+    size_t putVector(const std::vector<T>& v) { return put(v.data(), sizeof(T) * v.size()); }
+    void putState(const State& s) {
+        putVector(s.pos);
+        putVector(s.layout);
+    }
+    void patch(size_t off, int64_t value) {
+        if (buf != nullptr) memcpy(buf + off, &value, sizeof(value));
+    }
+private:
+    unsigned char* buf;
+    size_t cur;
+};
+
+// get / getState fail (nullptr / false) instead of reading past the buffer
+class Reader {
+public:
+    Reader(const unsigned char* buf, size_t size, size_t off): buf(buf), size(size), cur(off) {}
+    template<typename T>
+    const T* get(idx_t num = 1) {
+        if (num < 0 || cur > size || size_t(num) > (size - cur) / sizeof(T))
+            return nullptr;
+        const T* ret = reinterpret_cast<const T*>(buf + cur);
+        cur += align8(sizeof(T) * num);
+        return ret;
+    }
+    bool getState(int n, State& s) {
+        const int* pos = get<int>(n);
+        const int* layout = get<int>(n);
+        if (pos == nullptr || layout == nullptr) return false;
+        s = State(std::vector<int>(pos, pos + n), std::vector<int>(layout, layout + n));
+        return true;
+    }
+private:
+    const unsigned char* buf;
+    size_t size;
+    size_t cur;
+};
+
+size_t encode_gate_group(Writer& w, const GateGroup& gg) {
+    int numGates = gg.gates.size();
+    std::vector<int> ids(numGates);
+    std::vector<UqcGate> records(numGates);
+    std::vector<UqcError> errors;
+    for (int i = 0; i < numGates; i++) {
+        ids[i] = gg.gates[i].gateID;
+        if (w.counting()) {
+            errors.resize(errors.size() + gg.gates[i].controlErrors.size() + gg.gates[i].targetErrors.size());
+        } else {
+            to_uqc_gate(gg.gates[i], records[i], errors);
+        }
+    }
+    WireGateGroup h;
+    memset(&h, 0, sizeof(h));
+    h.relatedQubits = gg.relatedQubits;
+    h.numGates = numGates;
+    h.numErrors = errors.size();
+    h.numPerm = gg.cuttPerm.size();
+    h.matQubit = gg.matQubit;
+    h.backend = int32_t(gg.backend);
+    h.superGroup = gg.superGroup;
+    h.stateSize = gg.state.pos.size();
+    size_t off = w.put(h);
+    w.putVector(gg.cuttPerm);
+    w.putState(gg.state);
+    w.putVector(ids);
+    w.putVector(records);
+    w.putVector(errors);
+    return off;
+}
+
+size_t encode_local_group(Writer& w, const LocalGroup& lg) {
+    WireLocalGroup h;
+    memset(&h, 0, sizeof(h));
+    h.relatedQubits = lg.relatedQubits;
+    h.a2aCommSize = lg.a2aCommSize;
+    h.numA2a = lg.a2aComm.size();
+    h.numPerm = lg.cuttPerm.size();
+    h.numOverlap = lg.overlapGroups.size();
+    h.numFull = lg.fullGroups.size();
+    h.stateSize = lg.state.pos.size();
+    size_t off = w.put(h);
+    w.putVector(lg.a2aComm);
+    w.putVector(lg.cuttPerm);
+    w.putState(lg.state);
+    size_t table = w.skip(sizeof(int64_t) * (h.numOverlap + h.numFull));
+    int id = 0;
+    for (auto& gg: lg.overlapGroups)
+        w.patch(table + sizeof(int64_t) * (id++), encode_gate_group(w, gg));
+    for (auto& gg: lg.fullGroups)
+        w.patch(table + sizeof(int64_t) * (id++), encode_gate_group(w, gg));
+    return off;
+}
+
+void encode_schedule(Writer& w, const Schedule& s) {
+    WireHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = WIRE_MAGIC;
+    h.numLocalGroups = s.localGroups.size();
+    h.stateSize = s.finalState.pos.size();
+    h.qubitMapSize = s.qubitMap.pos.size();
+    size_t headerOff = w.put(h);
+    w.putState(s.finalState);
+    w.putState(s.qubitMap);
+    size_t table = w.skip(sizeof(int64_t) * h.numLocalGroups);
+    for (size_t i = 0; i < s.localGroups.size(); i++)
+        w.patch(table + sizeof(int64_t) * i, encode_local_group(w, s.localGroups[i]));
+    w.patch(headerOff + offsetof(WireHeader, size), w.size());
+}
+
+bool decode_gate_group(const unsigned char* buf, size_t size, size_t off, GateGroup& gg) {
+    Reader r(buf, size, off);
+    const WireGateGroup* h = r.get<WireGateGroup>();
+    if (h == nullptr) return false;
+    gg.relatedQubits = h->relatedQubits;
+    gg.matQubit = h->matQubit;
+    gg.backend = Backend(h->backend);
+    gg.superGroup = h->superGroup;
+    const int* perm = r.get<int>(h->numPerm);
+    if (perm == nullptr) return false;
+    gg.cuttPerm.assign(perm, perm + h->numPerm);
+    if (!r.getState(h->stateSize, gg.state)) return false;
+    const int* ids = r.get<int>(h->numGates);
+    const UqcGate* records = r.get<UqcGate>(h->numGates);
+    const UqcError* errors = r.get<UqcError>(h->numErrors);
+    if (ids == nullptr || records == nullptr || errors == nullptr) return false;
+    gg.gates.resize(h->numGates);
+    for (int i = 0; i < h->numGates; i++) {
+        const UqcGate& rec = records[i];
+        if (rec.errorOffset < 0 || rec.numControlErrors < 0 || rec.numTargetErrors < 0 ||
+            rec.errorOffset + rec.numControlErrors + rec.numTargetErrors > h->numErrors)
+            return false;
+        gg.gates[i].gateID = ids[i];
+        from_uqc_gate(rec, errors, gg.gates[i]);
+    }
+    return true;
+}
+
+bool decode_local_group(const unsigned char* buf, size_t size, size_t off, LocalGroup& lg) {
+    Reader r(buf, size, off);
+    const WireLocalGroup* h = r.get<WireLocalGroup>();
+    if (h == nullptr || h->numOverlap < 0 || h->numFull < 0) return false;
+    lg.relatedQubits = h->relatedQubits;
+    lg.a2aCommSize = h->a2aCommSize;
+    const int* comm = r.get<int>(h->numA2a);
+    const int* perm = r.get<int>(h->numPerm);
+    if (comm == nullptr || perm == nullptr) return false;
+    lg.a2aComm.assign(comm, comm + h->numA2a);
+    lg.cuttPerm.assign(perm, perm + h->numPerm);
+    if (!r.getState(h->stateSize, lg.state)) return false;
+    idx_t numGroups = idx_t(h->numOverlap) + h->numFull;
+    const int64_t* offsets = r.get<int64_t>(numGroups);
+    if (offsets == nullptr) return false;
+    lg.overlapGroups.resize(h->numOverlap);
+    lg.fullGroups.resize(h->numFull);
+    int numOverlap = h->numOverlap;
+    bool ok = true;
+    #pragma omp parallel for schedule(dynamic) reduction(&&: ok)
+    for (idx_t i = 0; i < numGroups; i++) {
+        GateGroup& gg = i < numOverlap ? lg.overlapGroups[i] : lg.fullGroups[i - numOverlap];
+        ok = decode_gate_group(buf, size, offsets[i], gg) && ok;
+    }
+    return ok;
+}
+
+}
+
+std::vector<unsigned char> Schedule::encode() const {
+    Writer counter(nullptr);
+    encode_schedule(counter, *this);
+    std::vector<unsigned char> result(counter.size());
+    Writer writer(result.data());
+    encode_schedule(writer, *this);
+    return result;
+}
+
+bool Schedule::tryDecode(const unsigned char* buf, size_t size, Schedule& s) {
+    Reader r(buf, size, 0);
+    const WireHeader* h = r.get<WireHeader>();
+    if (h == nullptr || h->magic != WIRE_MAGIC || h->size != size) return false;
+    if (!r.getState(h->stateSize, s.finalState) || !r.getState(h->qubitMapSize, s.qubitMap)) return false;
+    const int64_t* offsets = r.get<int64_t>(h->numLocalGroups);
+    if (offsets == nullptr) return false;
+    s.localGroups.resize(h->numLocalGroups);
+    for (idx_t i = 0; i < h->numLocalGroups; i++)
+        if (!decode_local_group(buf, size, offsets[i], s.localGroups[i])) return false;
+    return true;
+}
+
+Schedule Schedule::decode(const unsigned char* buf, size_t size) {
+    Schedule s;
+    if (!tryDecode(buf, size, s)) {
+        printf("corrupted schedule buffer\n");
+        exit(1);
+    }
+    return s;
+}
@@ -0,0 +1,153 @@
+#include "uqc.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "parser.h"
+
+bool is_uqc_file(const std::string& filename) {
+    return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".uqc") == 0;
+}
+
+namespace {
+
+inline void store_mat(double dst[2][2][2], const cpx mat[2][2]) {
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++) {
+            dst[i][j][0] = mat[i][j].real();
+            dst[i][j][1] = mat[i][j].imag();
+        }
+}
+
+inline void load_mat(cpx mat[2][2], const double src[2][2][2]) {
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+            mat[i][j] = cpx(src[i][j][0], src[i][j][1]);
+}
+
+UqcError to_record(const Error& e) {
+    UqcError r;
+    memset(&r, 0, sizeof(r));
+    r.type = int32_t(e.type);
+    cpx mat[2][2] = {{e.mat00, e.mat01}, {e.mat10, e.mat11}};
+    store_mat(r.mat, mat);
+    return r;
+}
+
+Error from_record(const UqcError& r) {
+    cpx mat[2][2];
+    load_mat(mat, r.mat);
+    return Error(GateType(r.type), mat[0][0], mat[0][1], mat[1][0], mat[1][1]);
+}
+
+}
+
+void to_uqc_gate(const Gate& g, UqcGate& r, std::vector<UqcError>& errors) {
+    memset(&r, 0, sizeof(r));
+    r.type = int32_t(g.type);
+    r.targetQubit = g.targetQubit;
+    r.controlQubit = g.controlQubit;
+    r.encodeQubit = g.encodeQubit;
+    memcpy(r.name, g.name.data(), std::min(g.name.size(), sizeof(r.name))); // not NUL terminated when full
+    store_mat(r.mat, g.mat);
+    r.errorOffset = errors.size();
+    r.numControlErrors = g.controlErrors.size();
+    r.numTargetErrors = g.targetErrors.size();
+    for (auto& e: g.controlErrors) errors.push_back(to_record(e));
+    for (auto& e: g.targetErrors) errors.push_back(to_record(e));
+}
+
+void from_uqc_gate(const UqcGate& r, const UqcError* errors, Gate& g) {
+    g.type = GateType(r.type);
+    load_mat(g.mat, r.mat);
+    g.name = std::string(r.name, strnlen(r.name, sizeof(r.name)));
+    g.targetQubit = r.targetQubit;
+    g.controlQubit = r.controlQubit;
+    g.encodeQubit = r.encodeQubit;
+    if (g.isMCGate()) {
+        for (int q = 0; q < 64; q++)
+            if (g.encodeQubit >> q & 1)
+                g.controlQubits.push_back(q);
+    }
+    const UqcError* e = errors + r.errorOffset;
+    for (int k = 0; k < r.numControlErrors; k++)
+        g.controlErrors.push_back(from_record(*(e++)));
+    for (int k = 0; k < r.numTargetErrors; k++)
+        g.targetErrors.push_back(from_record(*(e++)));
+}
+
+std::unique_ptr<Circuit> load_uqc(const std::string& filename) {
+    MappedFile file(filename);
+    const UqcHeader* header = reinterpret_cast<const UqcHeader*>(file.data);
+    if (file.size < sizeof(UqcHeader) || header->magic != UQC_MAGIC || header->version != UQC_VERSION) {
+        printf("%s is not a supported uqc file\n", filename.c_str());
+        exit(1);
+    }
+    // the density matrix doubles the qubits, an index has to fit in idx_t either way
+    if (header->numQubits <= 0 || header->numQubits > (MODE == 0 ? 62 : 31)) {
+        printf("%s: invalid number of qubits %d\n", filename.c_str(), header->numQubits);
+        exit(1);
+    }
+    idx_t numGates = header->numGates;
+    idx_t numErrors = header->numErrors;
+    size_t body = file.size - sizeof(UqcHeader);
+    // bound the counts before multiplying, so that the size check cannot overflow
+    if (numGates < 0 || numErrors < 0 || size_t(numGates) > body / sizeof(UqcGate) || size_t(numErrors) > body / sizeof(UqcError) ||
+        body != sizeof(UqcGate) * numGates + sizeof(UqcError) * numErrors) {
+        printf("%s is truncated\n", filename.c_str());
+        exit(1);
+    }
+    const UqcGate* records = reinterpret_cast<const UqcGate*>(header + 1);
+    const UqcError* errors = reinterpret_cast<const UqcError*>(records + numGates);
+#if MODE == 0
+    auto c = std::make_unique<Circuit>(header->numQubits);
+#elif MODE == 1 || MODE == 2
+    auto c = std::make_unique<Circuit>(header->numQubits * 2);
+#endif
+    std::vector<Gate> gates(numGates);
+    int firstID = Gate::reserveIDs(numGates);
+    #pragma omp parallel for
+    for (idx_t i = 0; i < numGates; i++) {
+        const UqcGate& r = records[i];
+        if (r.errorOffset < 0 || r.errorOffset + r.numControlErrors + r.numTargetErrors > numErrors) {
+            printf("%s: invalid error channels of gate %lld\n", filename.c_str(), i);
+            exit(1);
+        }
+        gates[i].gateID = firstID + i;
+        from_uqc_gate(r, errors, gates[i]);
+    }
+    c->addGates(std::move(gates));
+    return c;
+}
+
+void save_uqc(const std::string& filename, const Circuit& c) {
+    const std::vector<Gate>& gates = c.getGates();
+    std::vector<UqcGate> records(gates.size());
+    std::vector<UqcError> errors;
+    for (size_t i = 0; i < gates.size(); i++)
+        to_uqc_gate(gates[i], records[i], errors);
+    UqcHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = UQC_MAGIC;
+    header.version = UQC_VERSION;
+#if MODE == 0
+    header.numQubits = c.numQubits;
+#else
+    header.numQubits = c.numQubits / 2;
+#endif
+    header.numGates = records.size();
+    header.numErrors = errors.size();
+
+    FILE* f = fopen(filename.c_str(), "wb");
+    if (f == nullptr) {
+        printf("fail to open %s\n", filename.c_str());
+        exit(1);
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = ok && fwrite(records.data(), sizeof(UqcGate), records.size(), f) == records.size();
+    ok = ok && fwrite(errors.data(), sizeof(UqcError), errors.size(), f) == errors.size();
+    if (fclose(f) != 0 || !ok) {
+        printf("fail to write %s\n", filename.c_str());
+        exit(1);
+    }
+}
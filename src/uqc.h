@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "circuit.h"
+
+// .uqc binary circuit: a UqcHeader, numGates UqcGate records, then numErrors
+// UqcError records referenced by the gates. All fields are little endian and
+// matrices are always stored in double precision.
+const uint32_t UQC_MAGIC = 0x43515575; // "uUQC" in file byte order
+const uint32_t UQC_VERSION = 1;
+
+struct UqcHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t numQubits; // size of the qreg, before the density-matrix doubling
+    int32_t reserved;
+    int64_t numGates;
+    int64_t numErrors;
+};
+
+struct UqcGate {
+    int32_t type; // GateType
+    int32_t targetQubit;
+    int32_t controlQubit; // same encoding as Gate::controlQubit
+    int16_t numControlErrors;
+    int16_t numTargetErrors;
+    int64_t encodeQubit;
+    int64_t errorOffset; // first control error, the target errors follow
+    char name[8];
+    double mat[2][2][2]; // row, col, real/imag
+};
+
+struct UqcError {
+    int32_t type;
+    int32_t reserved;
+    double mat[2][2][2];
+};
+
+static_assert(sizeof(UqcHeader) == 32, "unexpected UqcHeader layout");
+static_assert(sizeof(UqcGate) == 104, "unexpected UqcGate layout");
+static_assert(sizeof(UqcError) == 72, "unexpected UqcError layout");
+
+// conversion between a Gate and its record, the error channels of the gate are
+// appended to / read from the error table
+void to_uqc_gate(const Gate& g, UqcGate& r, std::vector<UqcError>& errors);
+void from_uqc_gate(const UqcGate& r, const UqcError* errors, Gate& g); // does not set gateID
+
+bool is_uqc_file(const std::string& filename);
+std::unique_ptr<Circuit> load_uqc(const std::string& filename);
+void save_uqc(const std::string& filename, const Circuit& c);
@@ -13,8 +13,10 @@ namespace MyGlobalVars {
 int numGPUs;
 int localGPUs;
 int bit;
+int blockQubits;
 
 void init() {
+    blockQubits = LOCAL_QUBIT_SIZE;
 #ifdef USE_GPU
     CudaImpl::initCudaObjects();
 #else
@@ -20,22 +20,6 @@ typedef std::complex<float> cpx;
 #define MPI_Complex MPI_C_COMPLEX
 #endif
 
-#define SERIALIZE_STEP(x) { *reinterpret_cast<decltype(x)*>(arr + cur) = x; cur += sizeof(x); }
-#define DESERIALIZE_STEP(x) { x = *reinterpret_cast<const decltype(x)*>(arr + cur); cur += sizeof(x); }
-
-#define SERIALIZE_VECTOR(x, result) { \
-    auto tmp_chars = reinterpret_cast<const unsigned char*>(x.data()); \
-    result.insert(result.end(), tmp_chars, tmp_chars + sizeof(decltype(x)::value_type) * x.size()); \
-}
-
-#define DESERIALIZE_VECTOR(x, size) { \
-    x.resize(size); \
-    auto tmp_size = sizeof(decltype(x)::value_type) * size; \
-    memcpy(x.data(), arr + cur, tmp_size); \
-    cur += tmp_size; \
-}
-
-
 #define UNREACHABLE() { \
     printf("file %s line %i: unreachable!\n", __FILE__, __LINE__); \
     fflush(stdout); \
@@ -67,6 +51,7 @@ namespace MyGlobalVars {
     extern int numGPUs;
     extern int localGPUs;
     extern int bit;
+    extern int blockQubits; // qubits per block of the per-gate groups, LOCAL_QUBIT_SIZE unless tuned at runtime (cpu)
     void init();
 };
 
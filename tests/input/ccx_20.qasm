@@ -0,0 +1,523 @@
+OPENQASM 2.0;
+include "qelib1.inc";
+qreg q[20];
+h q[0];
+h q[1];
+h q[2];
+h q[3];
+h q[4];
+h q[5];
+h q[6];
+h q[7];
+h q[8];
+h q[9];
+h q[10];
+h q[11];
+h q[12];
+h q[13];
+h q[14];
+h q[15];
+h q[16];
+h q[17];
+h q[18];
+h q[19];
+ry(-0.179456) q[0];
+ry(1.369586) q[1];
+ry(-1.177492) q[2];
+ry(2.323790) q[3];
+ry(-0.539468) q[4];
+ry(1.299686) q[5];
+ry(-1.408673) q[6];
+ry(-1.529000) q[7];
+ry(1.875490) q[8];
+ry(-0.010192) q[9];
+ry(-0.504767) q[10];
+ry(1.366555) q[11];
+ry(2.779498) q[12];
+ry(-1.142825) q[13];
+ry(1.224359) q[14];
+ry(0.116104) q[15];
+ry(1.388161) q[16];
+ry(2.997979) q[17];
+ry(-1.761709) q[18];
+ry(1.515544) q[19];
+h q[4];
+cz q[14],q[4];
+ccx q[4],q[17],q[14];
+h q[4];
+ccx q[13],q[1],q[11];
+h q[14];
+cz q[13],q[14];
+ccx q[3],q[13],q[14];
+h q[14];
+ccx q[4],q[10],q[12];
+h q[11];
+cz q[10],q[11];
+ccx q[11],q[6],q[10];
+h q[11];
+ccx q[13],q[10],q[6];
+h q[7];
+cz q[13],q[7];
+ccx q[7],q[6],q[13];
+h q[7];
+ccx q[7],q[0],q[8];
+h q[10];
+cz q[16],q[10];
+ccx q[13],q[16],q[10];
+h q[10];
+ccx q[10],q[7],q[18];
+h q[11];
+cz q[14],q[11];
+ccx q[11],q[4],q[14];
+h q[11];
+ccx q[15],q[4],q[8];
+h q[10];
+cz q[12],q[10];
+ccx q[18],q[12],q[10];
+h q[10];
+ccx q[14],q[5],q[4];
+h q[6];
+cz q[10],q[6];
+ccx q[6],q[2],q[10];
+h q[6];
+ccx q[5],q[0],q[4];
+rz(-0.371172) q[0];
+rx(-1.585888) q[0];
+rz(-1.628731) q[1];
+rx(-1.826119) q[1];
+rz(-1.294557) q[2];
+rx(1.170254) q[2];
+rz(0.610227) q[3];
+rx(-0.107724) q[3];
+rz(2.277198) q[4];
+rx(0.983203) q[4];
+rz(-0.510572) q[5];
+rx(2.056372) q[5];
+rz(-1.191754) q[6];
+rx(-1.329449) q[6];
+rz(0.387238) q[7];
+rx(1.387866) q[7];
+rz(0.163885) q[8];
+rx(-0.028684) q[8];
+rz(2.346079) q[9];
+rx(1.705902) q[9];
+rz(-1.943292) q[10];
+rx(2.101033) q[10];
+rz(-1.080310) q[11];
+rx(1.500765) q[11];
+rz(2.348464) q[12];
+rx(-2.726342) q[12];
+rz(2.405521) q[13];
+rx(1.068126) q[13];
+rz(-0.738258) q[14];
+rx(1.448390) q[14];
+rz(2.703652) q[15];
+rx(-2.559793) q[15];
+rz(-1.622710) q[16];
+rx(0.106416) q[16];
+rz(2.671179) q[17];
+rx(-1.738554) q[17];
+rz(0.809915) q[18];
+rx(2.542843) q[18];
+rz(2.678700) q[19];
+rx(-1.957447) q[19];
+h q[18];
+cz q[15],q[18];
+ccx q[18],q[5],q[15];
+h q[18];
+ccx q[4],q[3],q[17];
+h q[0];
+cz q[19],q[0];
+ccx q[3],q[19],q[0];
+h q[0];
+ccx q[17],q[10],q[0];
+h q[8];
+cz q[3],q[8];
+ccx q[8],q[0],q[3];
+h q[8];
+ccx q[3],q[6],q[18];
+h q[14];
+cz q[6],q[14];
+ccx q[14],q[5],q[6];
+h q[14];
+ccx q[8],q[14],q[18];
+h q[12];
+cz q[6],q[12];
+ccx q[14],q[6],q[12];
+h q[12];
+ccx q[19],q[4],q[6];
+h q[9];
+cz q[5],q[9];
+ccx q[9],q[12],q[5];
+h q[9];
+ccx q[5],q[11],q[14];
+h q[3];
+cz q[0],q[3];
+ccx q[10],q[0],q[3];
+h q[3];
+ccx q[7],q[16],q[13];
+h q[6];
+cz q[1],q[6];
+ccx q[14],q[1],q[6];
+h q[6];
+ccx q[17],q[1],q[13];
+rz(-1.007747) q[0];
+rx(0.058861) q[0];
+rz(0.318261) q[1];
+rx(2.400100) q[1];
+rz(2.270443) q[2];
+rx(0.996608) q[2];
+rz(-2.054078) q[3];
+rx(0.626824) q[3];
+rz(-2.355059) q[4];
+rx(1.772607) q[4];
+rz(-0.414030) q[5];
+rx(2.742617) q[5];
+rz(-2.200643) q[6];
+rx(-2.848280) q[6];
+rz(-0.971199) q[7];
+rx(2.683484) q[7];
+rz(-1.485466) q[8];
+rx(-2.031634) q[8];
+rz(1.995259) q[9];
+rx(2.556703) q[9];
+rz(2.666067) q[10];
+rx(0.679780) q[10];
+rz(-2.039913) q[11];
+rx(1.621588) q[11];
+rz(-2.284528) q[12];
+rx(-0.445755) q[12];
+rz(2.731586) q[13];
+rx(0.031631) q[13];
+rz(-2.428367) q[14];
+rx(0.957819) q[14];
+rz(2.360292) q[15];
+rx(1.861539) q[15];
+rz(2.339038) q[16];
+rx(-1.359466) q[16];
+rz(-2.294195) q[17];
+rx(0.260446) q[17];
+rz(0.402941) q[18];
+rx(-1.725852) q[18];
+rz(0.502843) q[19];
+rx(-0.411708) q[19];
+h q[8];
+cz q[19],q[8];
+ccx q[13],q[19],q[8];
+h q[8];
+ccx q[7],q[0],q[16];
+h q[6];
+cz q[3],q[6];
+ccx q[12],q[3],q[6];
+h q[6];
+ccx q[13],q[14],q[5];
+h q[17];
+cz q[7],q[17];
+ccx q[9],q[7],q[17];
+h q[17];
+ccx q[8],q[18],q[11];
+h q[3];
+cz q[14],q[3];
+ccx q[3],q[12],q[14];
+h q[3];
+ccx q[9],q[10],q[16];
+h q[7];
+cz q[16],q[7];
+ccx q[18],q[16],q[7];
+h q[7];
+ccx q[11],q[7],q[13];
+h q[18];
+cz q[14],q[18];
+ccx q[18],q[9],q[14];
+h q[18];
+ccx q[6],q[14],q[17];
+h q[8];
+cz q[1],q[8];
+ccx q[12],q[1],q[8];
+h q[8];
+ccx q[6],q[8],q[13];
+h q[4];
+cz q[16],q[4];
+ccx q[4],q[10],q[16];
+h q[4];
+ccx q[17],q[4],q[2];
+rz(0.031316) q[0];
+rx(-0.218676) q[0];
+rz(-1.312577) q[1];
+rx(-1.515632) q[1];
+rz(0.110966) q[2];
+rx(1.433346) q[2];
+rz(2.725020) q[3];
+rx(2.777949) q[3];
+rz(2.466769) q[4];
+rx(-0.121375) q[4];
+rz(-0.811291) q[5];
+rx(-2.813467) q[5];
+rz(0.868256) q[6];
+rx(1.171867) q[6];
+rz(1.534453) q[7];
+rx(2.419730) q[7];
+rz(-2.391822) q[8];
+rx(0.673501) q[8];
+rz(-1.855172) q[9];
+rx(1.603507) q[9];
+rz(2.739331) q[10];
+rx(1.550297) q[10];
+rz(-1.474418) q[11];
+rx(1.837824) q[11];
+rz(1.646075) q[12];
+rx(1.025279) q[12];
+rz(0.123260) q[13];
+rx(2.649810) q[13];
+rz(1.803126) q[14];
+rx(-1.993445) q[14];
+rz(1.283585) q[15];
+rx(1.956910) q[15];
+rz(-2.584022) q[16];
+rx(-2.254820) q[16];
+rz(0.558744) q[17];
+rx(-2.218030) q[17];
+rz(-0.688092) q[18];
+rx(2.875618) q[18];
+rz(1.984062) q[19];
+rx(-2.412702) q[19];
+h q[7];
+cz q[18],q[7];
+ccx q[7],q[5],q[18];
+h q[7];
+ccx q[4],q[12],q[3];
+h q[10];
+cz q[4],q[10];
+ccx q[10],q[13],q[4];
+h q[10];
+ccx q[10],q[17],q[7];
+h q[8];
+cz q[0],q[8];
+ccx q[8],q[12],q[0];
+h q[8];
+ccx q[8],q[5],q[16];
+h q[6];
+cz q[8],q[6];
+ccx q[6],q[17],q[8];
+h q[6];
+ccx q[13],q[17],q[6];
+h q[19];
+cz q[4],q[19];
+ccx q[19],q[7],q[4];
+h q[19];
+ccx q[19],q[3],q[13];
+h q[13];
+cz q[16],q[13];
+ccx q[13],q[1],q[16];
+h q[13];
+ccx q[8],q[11],q[14];
+h q[9];
+cz q[11],q[9];
+ccx q[15],q[11],q[9];
+h q[9];
+ccx q[18],q[14],q[17];
+h q[9];
+cz q[1],q[9];
+ccx q[9],q[5],q[1];
+h q[9];
+ccx q[15],q[11],q[16];
+rz(-0.082520) q[0];
+rx(2.636762) q[0];
+rz(-2.612547) q[1];
+rx(1.421103) q[1];
+rz(2.855006) q[2];
+rx(-1.391433) q[2];
+rz(-1.907006) q[3];
+rx(-0.200444) q[3];
+rz(0.727496) q[4];
+rx(-2.153379) q[4];
+rz(-2.309259) q[5];
+rx(-2.704034) q[5];
+rz(1.538558) q[6];
+rx(1.484772) q[6];
+rz(1.252209) q[7];
+rx(-2.507305) q[7];
+rz(-0.121570) q[8];
+rx(2.665898) q[8];
+rz(0.160005) q[9];
+rx(1.048362) q[9];
+rz(2.070587) q[10];
+rx(1.020850) q[10];
+rz(0.974894) q[11];
+rx(0.934620) q[11];
+rz(0.805599) q[12];
+rx(-0.070570) q[12];
+rz(0.475189) q[13];
+rx(1.060974) q[13];
+rz(1.038039) q[14];
+rx(0.238472) q[14];
+rz(1.274253) q[15];
+rx(-1.146711) q[15];
+rz(2.989991) q[16];
+rx(-1.496158) q[16];
+rz(-2.765339) q[17];
+rx(0.735019) q[17];
+rz(1.756673) q[18];
+rx(-1.433721) q[18];
+rz(-0.928389) q[19];
+rx(-2.680759) q[19];
+h q[10];
+cz q[0],q[10];
+ccx q[10],q[18],q[0];
+h q[10];
+ccx q[9],q[14],q[16];
+h q[5];
+cz q[1],q[5];
+ccx q[3],q[1],q[5];
+h q[5];
+ccx q[8],q[12],q[1];
+h q[6];
+cz q[13],q[6];
+ccx q[6],q[4],q[13];
+h q[6];
+ccx q[0],q[14],q[11];
+h q[7];
+cz q[13],q[7];
+ccx q[7],q[3],q[13];
+h q[7];
+ccx q[19],q[14],q[10];
+h q[16];
+cz q[0],q[16];
+ccx q[13],q[0],q[16];
+h q[16];
+ccx q[14],q[6],q[4];
+h q[16];
+cz q[3],q[16];
+ccx q[16],q[13],q[3];
+h q[16];
+ccx q[12],q[15],q[14];
+h q[1];
+cz q[7],q[1];
+ccx q[14],q[7],q[1];
+h q[1];
+ccx q[16],q[2],q[8];
+h q[11];
+cz q[3],q[11];
+ccx q[17],q[3],q[11];
+h q[11];
+ccx q[2],q[10],q[15];
+rz(0.654589) q[0];
+rx(-0.147704) q[0];
+rz(1.485293) q[1];
+rx(1.743401) q[1];
+rz(1.824534) q[2];
+rx(-1.354933) q[2];
+rz(-0.557044) q[3];
+rx(1.948092) q[3];
+rz(0.003709) q[4];
+rx(-1.456028) q[4];
+rz(-2.328909) q[5];
+rx(-1.501071) q[5];
+rz(0.147197) q[6];
+rx(2.563410) q[6];
+rz(1.263583) q[7];
+rx(-0.426696) q[7];
+rz(1.520987) q[8];
+rx(-1.866967) q[8];
+rz(1.812793) q[9];
+rx(-1.380854) q[9];
+rz(-2.357546) q[10];
+rx(-2.024060) q[10];
+rz(-1.623806) q[11];
+rx(2.367750) q[11];
+rz(-1.358614) q[12];
+rx(-2.544436) q[12];
+rz(2.792268) q[13];
+rx(2.062291) q[13];
+rz(-1.497844) q[14];
+rx(2.401322) q[14];
+rz(2.869554) q[15];
+rx(-2.501843) q[15];
+rz(-0.779131) q[16];
+rx(-1.979747) q[16];
+rz(-0.838812) q[17];
+rx(1.704932) q[17];
+rz(1.849109) q[18];
+rx(0.460402) q[18];
+rz(1.555517) q[19];
+rx(-0.401210) q[19];
+h q[7];
+cz q[19],q[7];
+ccx q[1],q[19],q[7];
+h q[7];
+ccx q[4],q[11],q[8];
+h q[0];
+cz q[17],q[0];
+ccx q[14],q[17],q[0];
+h q[0];
+ccx q[7],q[11],q[14];
+h q[4];
+cz q[1],q[4];
+ccx q[4],q[6],q[1];
+h q[4];
+ccx q[18],q[3],q[14];
+h q[19];
+cz q[2],q[19];
+ccx q[19],q[7],q[2];
+h q[19];
+ccx q[2],q[5],q[14];
+h q[19];
+cz q[6],q[19];
+ccx q[19],q[7],q[6];
+h q[19];
+ccx q[13],q[18],q[2];
+h q[16];
+cz q[13],q[16];
+ccx q[12],q[13],q[16];
+h q[16];
+ccx q[4],q[7],q[11];
+h q[4];
+cz q[6],q[4];
+ccx q[4],q[15],q[6];
+h q[4];
+ccx q[4],q[8],q[13];
+h q[13];
+cz q[7],q[13];
+ccx q[12],q[7],q[13];
+h q[13];
+ccx q[5],q[12],q[18];
+rz(-0.331117) q[0];
+rx(0.432057) q[0];
+rz(-2.291496) q[1];
+rx(-1.379440) q[1];
+rz(-1.429444) q[2];
+rx(-2.117718) q[2];
+rz(-2.294378) q[3];
+rx(0.999706) q[3];
+rz(-2.511920) q[4];
+rx(-0.038404) q[4];
+rz(0.483290) q[5];
+rx(-2.246635) q[5];
+rz(-2.157120) q[6];
+rx(-0.237583) q[6];
+rz(0.643504) q[7];
+rx(-0.605980) q[7];
+rz(1.323510) q[8];
+rx(0.385729) q[8];
+rz(-0.541880) q[9];
+rx(-0.373014) q[9];
+rz(2.390220) q[10];
+rx(-1.065108) q[10];
+rz(0.439997) q[11];
+rx(2.052427) q[11];
+rz(0.144586) q[12];
+rx(2.041980) q[12];
+rz(2.856743) q[13];
+rx(0.680904) q[13];
+rz(2.709725) q[14];
+rx(-0.516805) q[14];
+rz(0.057137) q[15];
+rx(1.460754) q[15];
+rz(-0.801599) q[16];
+rx(-1.166263) q[16];
+rz(2.883104) q[17];
+rx(1.140879) q[17];
+rz(2.379837) q[18];
+rx(-1.357079) q[18];
+rz(-1.682577) q[19];
+rx(0.875004) q[19];
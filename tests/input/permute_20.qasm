@@ -0,0 +1,147 @@
+OPENQASM 2.0;
+include "qelib1.inc";
+qreg q[20];
+ry(2.669507) q[0];
+ry(2.818673) q[1];
+ry(2.465731) q[2];
+ry(-2.616628) q[3];
+ry(0.578224) q[4];
+ry(-0.479109) q[5];
+ry(0.189049) q[6];
+ry(-2.322875) q[7];
+ry(-1.935239) q[8];
+ry(-0.348255) q[9];
+ry(-1.752763) q[10];
+ry(-0.282536) q[11];
+ry(-2.985977) q[12];
+ry(-2.602658) q[13];
+ry(1.319520) q[14];
+ry(-0.494811) q[15];
+ry(0.079381) q[16];
+ry(1.471579) q[17];
+ry(-0.885952) q[18];
+ry(-2.779967) q[19];
+permute q[19],q[18],q[17],q[16],q[15],q[14],q[13],q[12],q[11],q[10],q[9],q[8],q[7],q[6],q[5],q[4],q[3],q[2],q[1],q[0];
+h q[0];
+cx q[0],q[7];
+h q[1];
+cx q[1],q[8];
+h q[2];
+cx q[2],q[9];
+h q[3];
+cx q[3],q[10];
+h q[4];
+cx q[4],q[11];
+h q[5];
+cx q[5],q[12];
+h q[6];
+cx q[6],q[13];
+h q[7];
+cx q[7],q[14];
+h q[8];
+cx q[8],q[15];
+h q[9];
+cx q[9],q[16];
+h q[10];
+cx q[10],q[17];
+h q[11];
+cx q[11],q[18];
+h q[12];
+cx q[12],q[19];
+h q[13];
+cx q[13],q[0];
+h q[14];
+cx q[14],q[1];
+h q[15];
+cx q[15],q[2];
+h q[16];
+cx q[16],q[3];
+h q[17];
+cx q[17],q[4];
+h q[18];
+cx q[18],q[5];
+h q[19];
+cx q[19],q[6];
+permute q[17],q[2],q[9],q[19],q[0],q[11];
+rz(1.778785) q[0];
+cu1(0.559979) q[0],q[5];
+rz(0.992195) q[2];
+cu1(0.760212) q[2],q[7];
+rz(2.957717) q[4];
+cu1(-0.862100) q[4],q[9];
+rz(1.632287) q[6];
+cu1(-0.825084) q[6],q[11];
+rz(0.452683) q[8];
+cu1(1.008653) q[8],q[13];
+rz(-1.166215) q[10];
+cu1(-2.602897) q[10],q[15];
+rz(-0.162945) q[12];
+cu1(1.369194) q[12],q[17];
+rz(0.569318) q[14];
+cu1(-0.330172) q[14],q[19];
+rz(0.894590) q[16];
+cu1(-1.997869) q[16],q[1];
+rz(-2.019793) q[18];
+cu1(-1.109533) q[18],q[3];
+permute q[15],q[13],q[7],q[8],q[10],q[14],q[19],q[1],q[5],q[11],q[12],q[4],q[9],q[0],q[18],q[17],q[2],q[3],q[6],q[16];
+ry(-1.517901) q[0];
+cz q[0],q[3];
+ry(-2.468492) q[1];
+cz q[1],q[4];
+ry(1.783225) q[2];
+cz q[2],q[5];
+ry(1.301521) q[3];
+cz q[3],q[6];
+ry(2.064437) q[4];
+cz q[4],q[7];
+ry(-1.646029) q[5];
+cz q[5],q[8];
+ry(0.285753) q[6];
+cz q[6],q[9];
+ry(2.631041) q[7];
+cz q[7],q[10];
+ry(0.582424) q[8];
+cz q[8],q[11];
+ry(2.798948) q[9];
+cz q[9],q[12];
+ry(-2.090669) q[10];
+cz q[10],q[13];
+ry(2.984554) q[11];
+cz q[11],q[14];
+ry(-2.790238) q[12];
+cz q[12],q[15];
+ry(-0.526384) q[13];
+cz q[13],q[16];
+ry(-2.994800) q[14];
+cz q[14],q[17];
+ry(1.945043) q[15];
+cz q[15],q[18];
+ry(1.176246) q[16];
+cz q[16],q[19];
+ry(2.976569) q[17];
+cz q[17],q[0];
+ry(1.916144) q[18];
+cz q[18],q[1];
+ry(2.820070) q[19];
+cz q[19],q[2];
+permute q[4],q[13];
+h q[0];
+h q[1];
+h q[2];
+h q[3];
+h q[4];
+h q[5];
+h q[6];
+h q[7];
+h q[8];
+h q[9];
+h q[10];
+h q[11];
+h q[12];
+h q[13];
+h q[14];
+h q[15];
+h q[16];
+h q[17];
+h q[18];
+h q[19];
@@ -0,0 +1,16 @@
+#include <cstdio>
+#include <string>
+#include "circuit.h"
+#include "parser.h"
+#include "uqc.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        printf("./qasm2uqc qasmfile uqcfile\n");
+        exit(1);
+    }
+    auto c = parse_circuit(std::string(argv[1]));
+    save_uqc(std::string(argv[2]), *c);
+    printf("%s: %d qubits %d gates\n", argv[2], c->numQubits, c->gateCount());
+    return 0;
+}